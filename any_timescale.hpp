@@ -0,0 +1,307 @@
+#ifndef TIMESCALES_ANY_TIMESCALE_HPP
+#define TIMESCALES_ANY_TIMESCALE_HPP
+
+#include "scale_simple.hpp"
+#include "scale_nanoseconds.hpp"
+#include "scale_with_timezone.hpp"
+#include "scale_derived.hpp"
+#include "scale_with_holidays.hpp"
+#include "timescales_typedefs.hpp"
+#include <typeinfo>
+
+namespace timescales {
+
+namespace detail {
+
+//! position of \a T in \a Types, sizeof...(Types) if it is not there
+template<class T, class... Types> struct index_of;
+
+template<class T> struct index_of<T> : std::integral_constant<size_t, 0> { };
+
+template<class T, class... Types> struct index_of<T, T, Types...> : std::integral_constant<size_t, 0> { };
+
+template<class T, class U, class... Types> struct index_of<T, U, Types...>
+  : std::integral_constant<size_t, 1 + index_of<T, Types...>::value> { };
+
+//! largest of \a Values
+template<size_t... Values> struct max_of;
+
+template<> struct max_of<> : std::integral_constant<size_t, 1> { };
+
+template<size_t Value, size_t... Values> struct max_of<Value, Values...>
+  : std::integral_constant<size_t, (Value > max_of<Values...>::value ? Value : max_of<Values...>::value)> { };
+
+}
+
+
+//! Value holding one scale out of the closed set \a Scales.
+/*! The scale is stored inline and every operation is dispatched on the index of its type through a table
+ *  of functions, with no heap allocation, no virtual call and no RTTI. Scales outside of the set remain
+ *  usable through the timescale base class.
+ */
+template<class... Scales>
+class basic_any_timescale {
+public:
+
+  //          //
+  // typedefs //
+  //          //
+
+  typedef basic_any_timescale<Scales...>  scale_type;
+
+  //! number of scales in the set
+  static const size_t size = sizeof...(Scales);
+
+  //! index of \a Scale in the set
+  template<class Scale>
+  struct index_of : detail::index_of<Scale, Scales...> { };
+
+
+  //              //
+  // constructors //
+  //              //
+
+  //! holds a copy of \a scale
+  template<class Scale>
+  basic_any_timescale(const Scale& scale) : _index(index_of<Scale>::value) {
+    static_assert(index_of<Scale>::value < size, "the scale is not part of the set");
+    new (&_storage) Scale(scale);
+  }
+
+  //! Copy constructor
+  basic_any_timescale(const scale_type& other) : _index(other._index) {
+    static void (*const table[])(void*, const void*) = { &copy_impl<Scales>... };
+    table[_index](&_storage, &other._storage);
+  }
+
+  //! Move constructor
+  basic_any_timescale(scale_type&& other) noexcept : _index(other._index) {
+    static void (*const table[])(void*, void*) = { &move_impl<Scales>... };
+    table[_index](&_storage, &other._storage);
+  }
+
+  ~basic_any_timescale() {
+    destroy();
+  }
+
+
+  //            //
+  // assignment //
+  //            //
+
+  //! assignment, leaves the scale held unchanged when the copy throws
+  scale_type& operator= (const scale_type& rhs) {
+    if(this != &rhs)
+      *this = scale_type(rhs);
+    return *this;
+  }
+
+  //! move assignment
+  scale_type& operator= (scale_type&& rhs) noexcept {
+    if(this != &rhs) {
+      destroy();
+      static void (*const table[])(void*, void*) = { &move_impl<Scales>... };
+      table[rhs._index](&_storage, &rhs._storage);
+      _index = rhs._index;
+    }
+    return *this;
+  }
+
+
+  //               //
+  // held instance //
+  //               //
+
+  //! index in the set of the type of the scale held
+  size_t index() const { return _index; }
+
+  //! the scale held if it is a \a Scale, nullptr otherwise
+  template<class Scale>
+  const Scale* get() const {
+    return _index == index_of<Scale>::value ? reinterpret_cast<const Scale*>(&_storage) : nullptr;
+  }
+
+  //! the scale held if it is a \a Scale, nullptr otherwise
+  template<class Scale>
+  Scale* get() {
+    return _index == index_of<Scale>::value ? reinterpret_cast<Scale*>(&_storage) : nullptr;
+  }
+
+  //! the scale held, through the open timescale hierarchy
+  const timescale& base() const {
+    static const timescale& (*const table[])(const void*) = { &base_impl<Scales>... };
+    return table[_index](&_storage);
+  }
+
+  //! calls \a visitor with the scale held, as its concrete type
+  template<class Result, class Visitor>
+  Result visit(Visitor&& visitor) const {
+    static Result (*const table[])(Visitor&, const void*) = { &visit_impl<Result, Visitor, Scales>... };
+    return table[_index](visitor, &_storage);
+  }
+
+
+  //                      //
+  // arithmetic operators //
+  //                      //
+
+  //! prefix ++ operator
+  scale_type& operator++ () {
+    return *this += 1;
+  }
+
+  //! postfix ++ operator
+  scale_type operator++ (int) {
+    scale_type tmp(*this);
+    *this += 1;
+    return tmp;
+  }
+
+  //! prefix -- operator
+  scale_type& operator-- () {
+    return *this -= 1;
+  }
+
+  //! postfix -- operator
+  scale_type operator-- (int) {
+    scale_type tmp(*this);
+    *this -= 1;
+    return tmp;
+  }
+
+  //! in-place + operator
+  scale_type& operator+= (unsigned long i) {
+    static void (*const table[])(void*, unsigned long) = { &add_impl<Scales>... };
+    table[_index](&_storage, i);
+    return *this;
+  }
+
+  //! + operator
+  scale_type operator+ (unsigned long i) const {
+    scale_type tmp(*this);
+    return (tmp += i);
+  }
+
+  //! in-place - operator
+  scale_type& operator-= (unsigned long i) {
+    static void (*const table[])(void*, unsigned long) = { &subtract_impl<Scales>... };
+    table[_index](&_storage, i);
+    return *this;
+  }
+
+  //! - operator
+  scale_type operator- (unsigned long i) const {
+    scale_type tmp(*this);
+    return (tmp -= i);
+  }
+
+
+  //                      //
+  // comparison operators //
+  //                      //
+
+  //! equality operator, false for scales of different types
+  bool operator== (const scale_type& rhs) const {
+    static bool (*const table[])(const void*, const void*) = { &equals_impl<Scales>... };
+    return _index == rhs._index && table[_index](&_storage, &rhs._storage);
+  }
+
+  //! inequality operator
+  bool operator!= (const scale_type& rhs) const {
+    return !(*this == rhs);
+  }
+
+
+  //                //
+  // length related //
+  //                //
+
+  //! instances difference, throws std::bad_cast for scales of different types
+  long operator- (const scale_type& rhs) const {
+    static long (*const table[])(const void*, const void*) = { &difference_impl<Scales>... };
+    if(_index != rhs._index)
+      throw std::bad_cast();
+    return table[_index](&_storage, &rhs._storage);
+  }
+
+
+  //              //
+  // current time //
+  //              //
+
+  local_date_time local_time() const {
+    static local_date_time (*const table[])(const void*) = { &local_time_impl<Scales>... };
+    return table[_index](&_storage);
+  }
+
+  ptime utc_time() const {
+    static ptime (*const table[])(const void*) = { &utc_time_impl<Scales>... };
+    return table[_index](&_storage);
+  }
+
+
+  //                       //
+  // string representation //
+  //                       //
+
+  //! writes the label of the current period to \a out, max_label_size chars long, returns its length
+  size_t label(char* out) const {
+    static size_t (*const table[])(const void*, char*) = { &label_impl<Scales>... };
+    return table[_index](&_storage, out);
+  }
+
+  //! string representation
+  std::string to_string() const {
+    static std::string (*const table[])(const void*) = { &to_string_impl<Scales>... };
+    return table[_index](&_storage);
+  }
+
+  //! ostream operator <<
+  friend std::ostream& operator << (std::ostream& out, const scale_type& scale) {
+    out << scale.to_string();
+    return out;
+  }
+
+private:
+  typename std::aligned_storage<detail::max_of<sizeof(Scales)...>::value,
+                                detail::max_of<std::alignment_of<Scales>::value...>::value>::type  _storage;
+  size_t                                                                                         _index;
+
+  void destroy() {
+    static void (*const table[])(void*) = { &destroy_impl<Scales>... };
+    table[_index](&_storage);
+  }
+
+  template<class Scale> static void copy_impl(void* p, const void* src) { new (p) Scale(*static_cast<const Scale*>(src)); }
+  template<class Scale> static void move_impl(void* p, void* src) noexcept { new (p) Scale(std::move(*static_cast<Scale*>(src))); }
+  template<class Scale> static void destroy_impl(void* p) { static_cast<Scale*>(p)->~Scale(); }
+  template<class Scale> static const timescale& base_impl(const void* p) { return *static_cast<const Scale*>(p); }
+  template<class Scale> static void add_impl(void* p, unsigned long i) { *static_cast<Scale*>(p) += i; }
+  template<class Scale> static void subtract_impl(void* p, unsigned long i) { *static_cast<Scale*>(p) -= i; }
+  template<class Scale> static bool equals_impl(const void* p, const void* q) { return *static_cast<const Scale*>(p) == *static_cast<const Scale*>(q); }
+  template<class Scale> static long difference_impl(const void* p, const void* q) { return *static_cast<const Scale*>(p) - *static_cast<const Scale*>(q); }
+  template<class Scale> static local_date_time local_time_impl(const void* p) { return static_cast<const Scale*>(p)->Scale::local_time(); }
+  template<class Scale> static ptime utc_time_impl(const void* p) { return static_cast<const Scale*>(p)->Scale::utc_time(); }
+  template<class Scale> static size_t label_impl(const void* p, char* out) { return static_cast<const Scale*>(p)->label(out); }
+  template<class Scale> static std::string to_string_impl(const void* p) { return static_cast<const Scale*>(p)->to_string(); }
+
+  template<class Result, class Visitor, class Scale>
+  static Result visit_impl(Visitor& visitor, const void* p) { return visitor(*static_cast<const Scale*>(p)); }
+};
+
+
+//! Any of the scales defined in timescales_typedefs.hpp
+typedef basic_any_timescale<utc_microseconds_scale, utc_milliseconds_scale, utc_seconds_scale, utc_minutes_scale,
+                            utc_hours_scale, utc_days_scale, utc_weeks_scale,
+                            utc_nanoseconds_scale, utc_microseconds_ns_scale, utc_milliseconds_ns_scale, utc_seconds_ns_scale,
+                            utc_minutes_ns_scale, utc_hours_ns_scale, utc_days_ns_scale, utc_weeks_ns_scale,
+                            microseconds_scale, milliseconds_scale, seconds_scale, minutes_scale, hours_scale,
+                            days_scale, weeks_scale, months_scale, years_scale,
+                            weekdays_scale, utc_weekdays_scale, weekend_days_scale, utc_weekend_days_scale,
+                            weekmask_scale, utc_weekmask_scale,
+                            days_with_holidays_scale, business_days>                   any_timescale;
+
+
+}
+
+#endif // TIMESCALES_ANY_TIMESCALE_HPP
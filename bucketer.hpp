@@ -0,0 +1,115 @@
+#ifndef TIMESCALES_BUCKETER_HPP
+#define TIMESCALES_BUCKETER_HPP
+
+#include "timescale.hpp"
+#include <boost/function.hpp>
+
+namespace timescales {
+
+//! Classifies a time-ordered stream of events into the periods of a \a Scale.
+/*! The bucketer keeps the current period of the scale and its utc bounds, [utc_time(), (scale+1).utc_time()),
+ *  in microseconds since 1970-01-01. An event inside them is classified with two comparisons; an event past
+ *  them moves the scale with operator++ when it lands in the next period, and builds the scale at its time
+ *  otherwise. Empty periods in between are skipped. Every period entered is reported to the open callback,
+ *  and every period left, or closed with close(), to the close callback. Before the anchor of the scale, where
+ *  its constructors truncate toward zero, the periods stepped through may differ from the constructed ones.
+ */
+template<class Scale>
+class bucketer {
+public:
+
+  //          //
+  // typedefs //
+  //          //
+
+  typedef Scale                                       scale_type;
+  typedef boost::function<void (const scale_type&)>   callback_type;
+
+
+  //              //
+  // constructors //
+  //              //
+
+  //! Constructor
+  /*! \param scale     scale whose periods classify the events, its current value is not used
+   *  \param on_open   called with each period entered
+   *  \param on_close  called with each period left
+   */
+  explicit bucketer(const scale_type& scale, const callback_type& on_open=callback_type(), const callback_type& on_close=callback_type())
+    : _scale(scale), _on_open(on_open), _on_close(on_close), _start(0), _end(0), _value(0), _open(false) { }
+
+
+  //        //
+  // events //
+  //        //
+
+  //! value of the period holding \a utc_us, in microseconds since 1970-01-01
+  long push(int64_t utc_us) {
+    if(_open && utc_us >= _start && utc_us < _end)
+      return _value;
+    if(_open) {
+      if(_on_close)
+        _on_close(_scale);
+      if(utc_us >= _end) {
+        ++_scale;
+        _start = _end;
+        _end = detail::epoch_microseconds((_scale + 1).Scale::utc_time());
+      }
+    }
+    if(!_open || utc_us < _start || utc_us >= _end) {
+      _scale = scale_type(detail::from_epoch_microseconds(utc_us), _scale);
+      _start = detail::epoch_microseconds(_scale.Scale::utc_time());
+      _end = detail::epoch_microseconds((_scale + 1).Scale::utc_time());
+      if(utc_us < _start)  // constructors truncate toward zero before the anchor
+        _start = utc_us;
+    }
+    _value = _scale.value();
+    _open = true;
+    if(_on_open)
+      _on_open(_scale);
+    return _value;
+  }
+
+  //! value of the period holding \a p
+  long push(const ptime& p) {
+    return push(detail::epoch_microseconds(p));
+  }
+
+  //! closes the current period, if any
+  void close() {
+    if(_open && _on_close)
+      _on_close(_scale);
+    _open = false;
+  }
+
+
+  //               //
+  // current state //
+  //               //
+
+  //! true between the first event and close()
+  bool is_open() const { return _open; }
+
+  //! scale at the current period
+  const scale_type& current() const { return _scale; }
+
+  //! start of the current period, in microseconds since 1970-01-01
+  int64_t start_microseconds() const { return _start; }
+
+  //! end of the current period, excluded, in microseconds since 1970-01-01
+  int64_t end_microseconds() const { return _end; }
+
+private:
+  scale_type     _scale;
+  callback_type  _on_open;
+  callback_type  _on_close;
+  int64_t        _start;
+  int64_t        _end;
+  long           _value;
+  bool           _open;
+};
+
+
+}
+
+#endif // TIMESCALES_BUCKETER_HPP
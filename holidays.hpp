@@ -4,6 +4,20 @@
 #include "timescale.hpp"
 #include <boost/function.hpp>
 #include <fstream>
+#include <atomic>
+#include <functional>
+#include <cstring>
+#include <sstream>
+#include <memory>
+#include <mutex>
+#include <typeinfo>
+#include <vector>
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
 
 
 namespace timescales {
@@ -15,8 +29,564 @@ typedef std::shared_ptr<holidays>                               holidays_ptr;
 typedef std::shared_ptr<const holidays>                         holidays_const_ptr;
 
 
+namespace detail {
+
+//! reads \a len bits (1 to 64) starting at bit \a pos of \a src
+inline uint64_t read_bits(const uint64_t* src, size_t pos, unsigned len) {
+  size_t w = pos >> 6;
+  unsigned o = pos & 63;
+  uint64_t v = src[w] >> o;
+  if(o && o + len > 64)
+    v |= src[w + 1] << (64 - o);
+  return len == 64 ? v : v & ((uint64_t(1) << len) - 1);
+}
+
+//! ors the \a len (1 to 64) low bits of \a v into \a dst, starting at bit \a pos
+inline void or_bits(uint64_t* dst, size_t pos, unsigned len, uint64_t v) {
+  size_t w = pos >> 6;
+  unsigned o = pos & 63;
+  dst[w] |= v << o;
+  if(o && o + len > 64)
+    dst[w + 1] |= v >> (64 - o);
+}
+
+//! ors \a n bits of \a src starting at \a src_pos into \a dst starting at \a dst_pos
+inline void copy_bits(const uint64_t* src, size_t src_pos, uint64_t* dst, size_t dst_pos, size_t n) {
+  while(n) {
+    unsigned len = n < 64 ? static_cast<unsigned>(n) : 64;
+    or_bits(dst, dst_pos, len, read_bits(src, src_pos, len));
+    src_pos += len;
+    dst_pos += len;
+    n -= len;
+  }
+}
+
+//! number of bits set among the \a n bits of \a src starting at \a pos
+inline long count_bits(const uint64_t* src, size_t pos, size_t n) {
+  long result = 0;
+  while(n) {
+    unsigned len = n < 64 ? static_cast<unsigned>(n) : 64;
+    result += popcount(read_bits(src, pos, len));
+    pos += len;
+    n -= len;
+  }
+  return result;
+}
+
+//! number of days in [first, last), 0 if the range is empty
+inline size_t days_in_range(const boost::gregorian::date& first, const boost::gregorian::date& last) {
+  if(first.is_special() || last.is_special())
+    throw std::logic_error("the range of dates cannot have special values");
+  return last > first ? static_cast<size_t>((last - first).days()) : 0;
+}
+
+
+//! Read-only calendar over an external array holding one bit per day.
+/*! Bit i of \a bits stands for the day number \a first_day + i, days outside of the covered range 
+ *  are never holidays.
+ */
+class holidays_bitmap_view {
+public:
+  holidays_bitmap_view() : _first_day(0), _ndays(0), _bits(nullptr) { }
+  holidays_bitmap_view(uint32_t first_day, uint32_t ndays, const uint64_t* bits) : _first_day(first_day), _ndays(ndays), _bits(bits) { }
+
+  //! true if \a d is marked in the bitmap
+  bool test(const boost::gregorian::date& d) const {
+    // special dates and dates before the range wrap around to large offsets
+    uint32_t i = static_cast<uint32_t>(d.day_number()) - _first_day;
+    return i < _ndays && ((_bits[i >> 6] >> (i & 63)) & 1);
+  }
+
+  //! true if no day is covered
+  bool empty() const { return _ndays == 0; }
+
+  //! ors the days marked in [first, last) into \a bits, bit i standing for day first+i
+  void fill(const boost::gregorian::date& first, const boost::gregorian::date& last, uint64_t* bits) const {
+    uint32_t from, to;
+    if(overlap(first, last, from, to))
+      copy_bits(_bits, from - _first_day, bits, from - first.day_number(), to - from);
+  }
+
+  //! number of days marked in [first, last)
+  long count(const boost::gregorian::date& first, const boost::gregorian::date& last) const {
+    uint32_t from, to;
+    return overlap(first, last, from, to) ? count_bits(_bits, from - _first_day, to - from) : 0;
+  }
+
+  uint32_t first_day() const { return _first_day; }
+  uint32_t ndays() const { return _ndays; }
+  const uint64_t* bits() const { return _bits; }
+
+private:
+  uint32_t         _first_day;
+  uint32_t         _ndays;
+  const uint64_t*  _bits;
+
+  //! intersection [from, to) of the day numbers of [first, last) and the covered range, false if empty
+  bool overlap(const boost::gregorian::date& first, const boost::gregorian::date& last, uint32_t& from, uint32_t& to) const {
+    if(days_in_range(first, last) == 0 || empty())
+      return false;
+    from = std::max(static_cast<uint32_t>(first.day_number()), _first_day);
+    to = std::min(static_cast<uint32_t>(last.day_number()), _first_day + _ndays);
+    return from < to;
+  }
+};
+
+
+//! Dense calendar holding one bit per day over a range of whole years.
+/*! Days outside of the covered range are never holidays.
+ */
+class holidays_bitmap {
+public:
+  holidays_bitmap() : _first_day(0), _ndays(0) { }
+
+  //! builds the bitmap covering all the years spanned by \a dates
+  explicit holidays_bitmap(const std::vector<boost::gregorian::date>& dates) : _first_day(0), _ndays(0) {
+    auto first = dates.end(), last = dates.end();
+    for(auto it=dates.begin(); it!=dates.end(); ++it) {
+      if(it->is_special())
+        continue;
+      if(first == dates.end() || *it < *first)
+        first = it;
+      if(last == dates.end() || *it > *last)
+        last = it;
+    }
+    if(first == dates.end())
+      return;
+    
+    extend(first->year(), last->year());
+    for(auto it=dates.begin(); it!=dates.end(); ++it)
+      if(!it->is_special())
+        set(*it);
+  }
+
+  //! read-only view of the bitmap, valid until it is next modified
+  holidays_bitmap_view view() const {
+    return holidays_bitmap_view(_first_day, _ndays, _bits.data());
+  }
+
+  //! true if \a d is marked in the bitmap
+  bool test(const boost::gregorian::date& d) const {
+    return view().test(d);
+  }
+
+  //! true if no day is covered
+  bool empty() const { return _ndays == 0; }
+
+  //! ors the days marked in [first, last) into \a bits, bit i standing for day first+i
+  void fill(const boost::gregorian::date& first, const boost::gregorian::date& last, uint64_t* bits) const {
+    view().fill(first, last, bits);
+  }
+
+  //! number of days marked in [first, last)
+  long count(const boost::gregorian::date& first, const boost::gregorian::date& last) const {
+    return view().count(first, last);
+  }
+
+  //! marks all the days marked in \a other
+  void merge(const holidays_bitmap_view& other) {
+    if(other.empty())
+      return;
+    extend(boost::gregorian::gregorian_calendar::from_day_number(other.first_day()).year, 
+           boost::gregorian::gregorian_calendar::from_day_number(other.first_day() + other.ndays() - 1).year);
+    
+    uint32_t shift = other.first_day() - _first_day;
+    for(uint32_t w=0; w<(other.ndays() + 63) / 64; ++w)
+      for(uint64_t word=other.bits()[w]; word; word &= word - 1) {
+        uint32_t i = 64 * w + lowest_bit(word);
+        if(i >= other.ndays())
+          break;
+        set_offset(shift + i);
+      }
+  }
+
+  //! marks all the days marked in \a other
+  void merge(const holidays_bitmap& other) {
+    merge(other.view());
+  }
+
+private:
+  uint32_t               _first_day;
+  uint32_t               _ndays;
+  std::vector<uint64_t>  _bits;
+
+  //! grows the covered range to include the years [first_year, last_year]
+  void extend(int first_year, int last_year) {
+    uint32_t first_day = boost::gregorian::date(first_year, 1, 1).day_number();
+    uint32_t last_day = boost::gregorian::date(last_year, 12, 31).day_number();
+    if(!empty()) {
+      first_day = std::min(first_day, _first_day);
+      last_day = std::max(last_day, _first_day + _ndays - 1);
+      if(first_day == _first_day && last_day == _first_day + _ndays - 1)
+        return;
+    }
+
+    holidays_bitmap old;
+    std::swap(old, *this);
+    _first_day = first_day;
+    _ndays = last_day - first_day + 1;
+    _bits.assign((_ndays + 63) / 64, 0);
+    merge(old);
+  }
+
+  void set(const boost::gregorian::date& d) {
+    set_offset(static_cast<uint32_t>(d.day_number()) - _first_day);
+  }
+
+  void set_offset(uint32_t i) {
+    _bits[i >> 6] |= uint64_t(1) << (i & 63);
+  }
+};
+
+
+//! Calendar holding one bitset per year, each computed the first time one of its days is queried.
+/*! Years are published with atomic pointers, so concurrent readers need no locking. Two threads 
+ *  hitting a missing year at the same time may both compute it, only one result is kept.
+ */
+class lazy_holidays_bitmap {
+public:
+  //! fills \a bits with the holidays of \a year, bit i being the day of the year i+1
+  typedef boost::function<void (int year, uint64_t* bits)>   filler_type;
+  
+  explicit lazy_holidays_bitmap(const filler_type& filler) : _filler(filler) { 
+    for(size_t i=0; i<n_centuries; ++i)
+      _centuries[i].store(nullptr, std::memory_order_relaxed);
+  }
+
+  lazy_holidays_bitmap(const lazy_holidays_bitmap&) = delete;
+  lazy_holidays_bitmap& operator=(const lazy_holidays_bitmap&) = delete;
+  
+  ~lazy_holidays_bitmap() {
+    for(size_t i=0; i<n_centuries; ++i)
+      delete _centuries[i].load(std::memory_order_relaxed);
+  }
+  
+  //! true if \a d is marked in the bitmap
+  bool test(const boost::gregorian::date& d) const {
+    if(d.is_special())
+      return false;
+    unsigned doy = d.day_of_year() - 1;
+    return (year(d.year())->bits[doy >> 6] >> (doy & 63)) & 1;
+  }
+
+  //! ors the days marked in [first, last) into \a bits, bit i standing for day first+i
+  void fill(const boost::gregorian::date& first, const boost::gregorian::date& last, uint64_t* bits) const {
+    size_t n = days_in_range(first, last);
+    size_t pos = 0;
+    while(pos < n) {
+      boost::gregorian::date d = first + boost::gregorian::days(pos);
+      size_t doy = d.day_of_year() - 1;
+      size_t len = std::min(n - pos, (boost::gregorian::gregorian_calendar::is_leap_year(d.year()) ? 366 : 365) - doy);
+      copy_bits(year(d.year())->bits, doy, bits, pos, len);
+      pos += len;
+    }
+  }
+
+  //! computes all the years in [first, last] now rather than on their first query
+  void prepare(int first, int last) const {
+    for(int y=(first < first_year ? first_year : first); y<=last && y<=last_year; ++y)
+      year(y);
+  }
+
+private:
+  static const int      first_year  = 1400;       // range of boost::gregorian::date
+  static const int      last_year   = 9999;
+  static const size_t   n_centuries = 86;
+  
+  struct year_bits {
+    uint64_t bits[6];
+  };
+  
+  struct century {
+    std::atomic<const year_bits*> years[100];
+    
+    century() {
+      for(size_t i=0; i<100; ++i)
+        years[i].store(nullptr, std::memory_order_relaxed);
+    }
+    ~century() {
+      for(size_t i=0; i<100; ++i)
+        delete years[i].load(std::memory_order_relaxed);
+    }
+  };
+  
+  filler_type                     _filler;
+  mutable std::atomic<century*>   _centuries[n_centuries];
+  
+  const year_bits* year(int y) const {
+    size_t i = static_cast<size_t>(y - first_year);
+    
+    century* c = _centuries[i / 100].load(std::memory_order_acquire);
+    if(!c) {
+      std::unique_ptr<century> fresh(new century());
+      if(_centuries[i / 100].compare_exchange_strong(c, fresh.get(), std::memory_order_acq_rel))
+        c = fresh.release();
+    }
+
+    const year_bits* yb = c->years[i % 100].load(std::memory_order_acquire);
+    if(!yb) {
+      std::unique_ptr<year_bits> fresh(new year_bits());
+      std::fill(fresh->bits, fresh->bits + 6, 0);
+      _filler(y, fresh->bits);
+      if(c->years[i % 100].compare_exchange_strong(yb, fresh.get(), std::memory_order_acq_rel))
+        yb = fresh.release();
+    }
+    return yb;
+  }
+};
+
+
+//! Header of the binary calendar files, followed by the words of the bitmap in native byte order.
+struct binary_holidays_header {
+  static const uint32_t current_version = 1;
+  static const uint32_t native_order = 0x01020304;
+
+  char      magic[8];         // "TSHOLBIN"
+  uint32_t  byte_order;       // native_order on the machine that wrote the file
+  uint32_t  version;
+  uint32_t  first_day;        // day number of the first covered day
+  uint32_t  ndays;            // number of covered days
+
+  static const char* expected_magic() { return "TSHOLBIN"; }
+};
+
+static_assert(sizeof(binary_holidays_header) == 24, "the bitmap words must stay 8-byte aligned");
+
+
+#if defined(__unix__) || defined(__APPLE__)
+
+//! Read-only memory map of a whole file, data() is null when the file is empty or cannot be mapped.
+class mapped_file {
+public:
+  explicit mapped_file(const std::string& filename) : _data(nullptr), _size(0) {
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if(fd < 0)
+      throw std::runtime_error("Cannot open file '" + filename + "'");
+    struct stat st;
+    if(::fstat(fd, &st) == 0 && st.st_size > 0) {
+      void* data = ::mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+      if(data != MAP_FAILED) {
+        _data = data;
+        _size = static_cast<size_t>(st.st_size);
+      }
+    }
+    ::close(fd);
+  }
+
+  mapped_file(const mapped_file&) = delete;
+  mapped_file& operator=(const mapped_file&) = delete;
+
+  ~mapped_file() {
+    if(_data)
+      ::munmap(_data, _size);
+  }
+
+  const void* data() const { return _data; }
+  size_t size() const { return _size; }
+
+private:
+  void*   _data;
+  size_t  _size;
+};
+
+#else
+
+//! Whole file read in memory where memory maps are not available, data() is null when the file is empty.
+class mapped_file {
+public:
+  explicit mapped_file(const std::string& filename) : _size(0) {
+    std::ifstream file(filename, std::ios_base::in | std::ios_base::binary | std::ios_base::ate);
+    if(!file.is_open())
+      throw std::runtime_error("Cannot open file '" + filename + "'");
+    const std::streamoff size = file.tellg();
+    if(size <= 0)
+      return;
+    _words.resize((static_cast<size_t>(size) + 7) / 8);   // words keep the bitmap aligned
+    file.seekg(0);
+    if(file.read(reinterpret_cast<char*>(_words.data()), size))
+      _size = static_cast<size_t>(size);
+  }
+
+  const void* data() const { return _size ? _words.data() : nullptr; }
+  size_t size() const { return _size; }
+
+private:
+  std::vector<uint64_t>  _words;
+  size_t                 _size;
+};
+
+#endif
+
+
+//! Incremental parser of text calendars, one YYYYMMDD date per line.
+/*! Blocks of any size are fed in turn, lines may span several blocks. Blank characters around the date 
+ *  are ignored, as is anything after a '#'.
+ */
+class holidays_text_parser {
+public:
+  explicit holidays_text_parser(const std::string& filename) : _filename(filename), _line(1) { 
+    reset();
+  }
+
+  //! parses the characters in [first, last), appending the dates found to \a result
+  void feed(const char* first, const char* last, std::vector<boost::gregorian::date>& result) {
+    for(const char* p=first; p!=last; ++p) {
+      const char c = *p;
+      if(c == '\n') {
+        end_line(result);
+        ++_line;
+        continue;
+      }
+      if(_comment)
+        continue;
+      if(c == '#') {
+        _comment = true;
+        continue;
+      }
+      if(c == ' ' || c == '\t' || c == '\r') {
+        _ended = _length > 0;
+        continue;
+      }
+      if(_length < sizeof(_text))
+        _text[_length] = c;
+      ++_length;
+      if(c >= '0' && c <= '9' && !_ended && _length <= 8)
+        _value = _value * 10 + static_cast<unsigned>(c - '0');
+      else
+        _bad = true;
+    }
+  }
+
+  //! parses a last line without end of line, if any
+  void finish(std::vector<boost::gregorian::date>& result) {
+    end_line(result);
+  }
+
+private:
+  std::string  _filename;
+  size_t       _line;
+  char         _text[16];   // first characters of the date, for error messages
+  size_t       _length;
+  unsigned     _value;
+  bool         _comment;
+  bool         _ended;
+  bool         _bad;
+
+  void reset() {
+    _length = 0;
+    _value = 0;
+    _comment = _ended = _bad = false;
+  }
+
+  void end_line(std::vector<boost::gregorian::date>& result) {
+    if(_length == 0) {      // blank lines and comments
+      reset();
+      return;
+    }
+    
+    const unsigned year = _value / 10000, month = _value / 100 % 100, day = _value % 100;
+    if(_bad || _length != 8 || year < 1400 || month < 1 || month > 12 || day < 1 || 
+       day > boost::gregorian::gregorian_calendar::end_of_month_day(year, month)) {
+      std::ostringstream message;
+      message << "Cannot read a valid date from '" << std::string(_text, std::min(_length, sizeof(_text))) 
+              << (_length > sizeof(_text) ? "...'" : "'") << " at line " << _line << " of '" << _filename << "'";
+      throw std::runtime_error(message.str());
+    }
+    result.push_back(boost::gregorian::date(year, month, day));
+    reset();
+  }
+};
+
+
+//! Indexes built over a calendar by the scales using it, so that the scales built alike share them.
+/*! Entries are found by the type of the index and a key of type Index::key_type. Only the indexes a scale 
+ *  still holds are returned, and the expired entries are dropped when a new key is stored. Copies of a 
+ *  calendar start with an empty cache.
+ */
+class holidays_index_cache {
+public:
+  holidays_index_cache() { }
+  holidays_index_cache(const holidays_index_cache&) { }
+  holidays_index_cache& operator=(const holidays_index_cache&) { return *this; }
+
+  //! index stored under \a key, null when there is none in use
+  template<class Index>
+  std::shared_ptr<const Index> find(const typename Index::key_type& key) const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    const entry* e = lookup<Index>(key);
+    return e ? std::static_pointer_cast<const Index>(e->index.lock()) : std::shared_ptr<const Index>();
+  }
+
+  //! stores \a idx under \a key, in place of the index stored there
+  template<class Index>
+  void store(const typename Index::key_type& key, const std::shared_ptr<const Index>& idx) const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if(entry* e = lookup<Index>(key)) {
+      e->index = idx;
+      return;
+    }
+    for(auto it=_entries.begin(); it!=_entries.end(); )
+      it = it->index.expired() ? _entries.erase(it) : ++it;
+    _entries.push_back(entry { &typeid(Index), std::make_shared<const typename Index::key_type>(key), idx });
+  }
+
+private:
+  struct entry {
+    const std::type_info*       type;
+    std::shared_ptr<const void> key;
+    std::weak_ptr<const void>   index;
+  };
+
+  mutable std::mutex          _mutex;
+  mutable std::vector<entry>  _entries;
+
+  template<class Index>
+  entry* lookup(const typename Index::key_type& key) const {
+    for(auto it=_entries.begin(); it!=_entries.end(); ++it)
+      if(*it->type == typeid(Index) && *static_cast<const typename Index::key_type*>(it->key.get()) == key)
+        return &*it;
+    return nullptr;
+  }
+};
+
+}
+
+
 struct holidays {
   virtual bool is_holiday(const boost::gregorian::date& d) const = 0;
+
+  //! indexes of the scales over this calendar, see scale_with_holidays
+  const detail::holidays_index_cache& index_cache() const { return _index_cache; }
+
+  //! ors the holidays in [first, last) into \a bits, bit i standing for day first+i
+  /*! \a bits must hold at least (last - first + 63) / 64 words, and is usually zeroed by the caller.
+   */
+  virtual void fill_holidays(const boost::gregorian::date& first, const boost::gregorian::date& last, uint64_t* bits) const {
+    size_t n = detail::days_in_range(first, last);
+    for(size_t i=0; i<n; ++i)
+      if(is_holiday(first + boost::gregorian::days(i)))
+        bits[i >> 6] |= uint64_t(1) << (i & 63);
+  }
+
+  //! number of holidays in [first, last)
+  virtual long count_holidays(const boost::gregorian::date& first, const boost::gregorian::date& last) const {
+    size_t n = detail::days_in_range(first, last);
+    std::vector<uint64_t> bits((n + 63) / 64, 0);
+    if(n)
+      fill_holidays(first, last, bits.data());
+    return detail::count_bits(bits.data(), 0, n);
+  }
+
+  //! adds this calendar to a flattened composite
+  /*! Holidays known as a fixed set of dates are merged into \a bitmap, anything that can only be 
+   *  queried is appended to \a dynamic. \a self must point to this calendar.
+   */
+  virtual void flatten(detail::holidays_bitmap& bitmap, std::vector<holidays_const_ptr>& dynamic, const holidays_const_ptr& self) const {
+    dynamic.push_back(self);
+  }
+
+private:
+  detail::holidays_index_cache _index_cache;
 };
 
 
@@ -24,52 +594,126 @@ struct no_holidays : public holidays {
   bool is_holiday(const boost::gregorian::date& d) const {
     return false;
   }
+  void fill_holidays(const boost::gregorian::date& first, const boost::gregorian::date& last, uint64_t* bits) const {
+    detail::days_in_range(first, last);
+  }
+  long count_holidays(const boost::gregorian::date& first, const boost::gregorian::date& last) const {
+    detail::days_in_range(first, last);
+    return 0;
+  }
+  void flatten(detail::holidays_bitmap& bitmap, std::vector<holidays_const_ptr>& dynamic, const holidays_const_ptr& self) const {
+  }
 };
 
 
 struct holidays_from_vector : public holidays {
-  holidays_from_vector(const std::vector<boost::gregorian::date>& all_holidays) : _holidays(all_holidays) { 
-    std::sort(_holidays.begin(), _holidays.end());
-  }
+  holidays_from_vector(const std::vector<boost::gregorian::date>& all_holidays) : _bitmap(all_holidays) { }
   bool is_holiday(const boost::gregorian::date& d) const {
-    return std::binary_search(_holidays.begin(), _holidays.end(), d);
+    return _bitmap.test(d);
+  }
+  void fill_holidays(const boost::gregorian::date& first, const boost::gregorian::date& last, uint64_t* bits) const {
+    _bitmap.fill(first, last, bits);
+  }
+  long count_holidays(const boost::gregorian::date& first, const boost::gregorian::date& last) const {
+    return _bitmap.count(first, last);
+  }
+  void flatten(detail::holidays_bitmap& bitmap, std::vector<holidays_const_ptr>& dynamic, const holidays_const_ptr& self) const {
+    bitmap.merge(_bitmap);
   }
 protected:
-  std::vector<boost::gregorian::date> _holidays;
+  detail::holidays_bitmap _bitmap;
 };
 
 
 struct holidays_from_file : public holidays_from_vector {
   holidays_from_file(const std::string& filename) : holidays_from_vector(holidays_from_file::vector_from_file(filename)) { }
-private:
+
+  //! reads the dates listed in a text calendar, one YYYYMMDD date per line
   static std::vector<boost::gregorian::date> vector_from_file(const std::string& filename)  {
     // vector to hold the result
     std::vector<boost::gregorian::date>  result;
     
     // open the file
-    std::ifstream file(filename, std::ios_base::in);
+    std::ifstream file(filename, std::ios_base::in | std::ios_base::binary);
     if(!file.is_open())
       throw std::runtime_error("Cannot open file '" + filename + "'");
 
-    std::string line_string;
-    while(std::getline(file, line_string)) {
-      line_string = line_string.substr(0, line_string.find_last_not_of(" \t", line_string.find('#')-1)+1);
-      if(line_string.empty() || line_string.at(0) == '#')   // ignore empty lines and comments
-        continue;
-      try {
-        boost::gregorian::date d(boost::gregorian::from_undelimited_string(line_string)); 
-        result.push_back(d);
-      }
-      catch(std::out_of_range&) {
-        throw std::runtime_error("Cannot read a valid date from '" + line_string + "'");
-      }
-    }
-      
+    detail::holidays_text_parser parser(filename);
+    std::vector<char> block(1 << 16);
+    std::streamsize n;
+    while((n = file.rdbuf()->sgetn(block.data(), block.size())) > 0)
+      parser.feed(block.data(), block.data() + n, result);
+    parser.finish(result);
+    
     return result;
   }
 };
 
 
+//! Calendar read from a binary file written by write_holidays_binary.
+/*! The file is mapped in memory, or read in one block where the platform has no memory maps, and queried 
+ *  in place: there is no parsing nor sorting. Files written on a machine with a different byte order are 
+ *  rejected.
+ */
+struct holidays_from_binary_file : public holidays {
+  holidays_from_binary_file(const std::string& filename) : _file(filename) {
+    const detail::binary_holidays_header* header = static_cast<const detail::binary_holidays_header*>(_file.data());
+    if(!header || _file.size() < sizeof(*header) ||
+       std::memcmp(header->magic, detail::binary_holidays_header::expected_magic(), sizeof(header->magic)) != 0 ||
+       header->byte_order != detail::binary_holidays_header::native_order ||
+       header->version != detail::binary_holidays_header::current_version ||
+       (_file.size() - sizeof(*header)) / sizeof(uint64_t) < (uint64_t(header->ndays) + 63) / 64 ||
+       uint64_t(header->first_day) + header->ndays > boost::gregorian::date(boost::gregorian::max_date_time).day_number() + 1)
+      throw std::runtime_error("Cannot read a binary calendar from '" + filename + "'");
+    _bitmap = detail::holidays_bitmap_view(header->first_day, header->ndays, 
+                                           reinterpret_cast<const uint64_t*>(static_cast<const char*>(_file.data()) + sizeof(*header)));
+  }
+  
+  bool is_holiday(const boost::gregorian::date& d) const {
+    return _bitmap.test(d);
+  }
+  void fill_holidays(const boost::gregorian::date& first, const boost::gregorian::date& last, uint64_t* bits) const {
+    _bitmap.fill(first, last, bits);
+  }
+  long count_holidays(const boost::gregorian::date& first, const boost::gregorian::date& last) const {
+    return _bitmap.count(first, last);
+  }
+  void flatten(detail::holidays_bitmap& bitmap, std::vector<holidays_const_ptr>& dynamic, const holidays_const_ptr& self) const {
+    bitmap.merge(_bitmap);
+  }
+private:
+  detail::mapped_file           _file;
+  detail::holidays_bitmap_view  _bitmap;
+};
+
+
+//! writes \a dates to \a filename in the format read by holidays_from_binary_file
+inline void write_holidays_binary(const std::string& filename, const std::vector<boost::gregorian::date>& dates) {
+  const detail::holidays_bitmap bitmap(dates);
+  const detail::holidays_bitmap_view view = bitmap.view();
+  
+  detail::binary_holidays_header header;
+  std::memcpy(header.magic, detail::binary_holidays_header::expected_magic(), sizeof(header.magic));
+  header.byte_order = detail::binary_holidays_header::native_order;
+  header.version = detail::binary_holidays_header::current_version;
+  header.first_day = view.first_day();
+  header.ndays = view.ndays();
+  
+  std::ofstream file(filename, std::ios_base::out | std::ios_base::binary | std::ios_base::trunc);
+  if(!file.is_open())
+    throw std::runtime_error("Cannot open file '" + filename + "'");
+  file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  file.write(reinterpret_cast<const char*>(view.bits()), sizeof(uint64_t) * ((view.ndays() + 63) / 64));
+  if(!file.flush())
+    throw std::runtime_error("Cannot write to file '" + filename + "'");
+}
+
+//! converts the text calendar \a text_filename, as read by holidays_from_file, to the binary \a binary_filename
+inline void convert_holidays_file(const std::string& text_filename, const std::string& binary_filename) {
+  write_holidays_binary(binary_filename, holidays_from_file::vector_from_file(text_filename));
+}
+
+
 struct holidays_from_callback : public holidays {
   holidays_from_callback(const callback_type& callback_fn) : _callback(callback_fn) { }
   bool is_holiday(const boost::gregorian::date& d) const {
@@ -80,16 +724,215 @@ private:
 };
 
 
+//! Calendar from a callback evaluated at most once per day.
+/*! The callback is evaluated for a whole year the first time one of its days is queried, later queries 
+ *  are served from a per-year bitset. Safe for concurrent readers, but the callback may be called from 
+ *  several threads at once.
+ */
+struct holidays_from_cached_callback : public holidays {
+  holidays_from_cached_callback(const callback_type& callback_fn) : _bitmap(std::bind(&holidays_from_cached_callback::fill_year, callback_fn, std::placeholders::_1, std::placeholders::_2)) { }
+  bool is_holiday(const boost::gregorian::date& d) const {
+    return _bitmap.test(d);
+  }
+  void fill_holidays(const boost::gregorian::date& first, const boost::gregorian::date& last, uint64_t* bits) const {
+    _bitmap.fill(first, last, bits);
+  }
+private:
+  detail::lazy_holidays_bitmap _bitmap;
+
+  static void fill_year(const callback_type& callback_fn, int year, uint64_t* bits) {
+    const boost::gregorian::date first(year, 1, 1);
+    const unsigned ndays = boost::gregorian::gregorian_calendar::is_leap_year(year) ? 366 : 365;
+    for(unsigned i=0; i<ndays; ++i)
+      if(callback_fn(first + boost::gregorian::days(i)))
+        bits[i >> 6] |= uint64_t(1) << (i & 63);
+  }
+};
+
+
+//! Rule giving the date of a holiday each year.
+class holiday_rule {
+public:
+  //! how a holiday on a fixed date falling on a weekend is observed
+  enum observance_type {
+    actual_day,             //!< on the weekend day itself
+    nearest_weekday,        //!< on Friday if it falls on Saturday, on Monday if it falls on Sunday
+    following_monday        //!< on Monday if it falls on Saturday or Sunday
+  };
+
+  //! holiday on \a month / \a day, not observed in the years without that day
+  static holiday_rule fixed_date(unsigned month, unsigned day, observance_type observance=actual_day) {
+    if(month < 1 || month > 12 || day < 1 || day > boost::gregorian::gregorian_calendar::end_of_month_day(2000, month))
+      throw std::logic_error("invalid day of the year");
+    return holiday_rule(fixed, month, day, 0, observance);
+  }
+
+  //! holiday on the \a n th (1 to 5) \a weekday of \a month, not observed in the months without one
+  static holiday_rule nth_weekday(unsigned n, boost::date_time::weekdays weekday, unsigned month) {
+    if(n < 1 || n > 5 || weekday < boost::date_time::Sunday || weekday > boost::date_time::Saturday || month < 1 || month > 12)
+      throw std::logic_error("invalid weekday of the month");
+    return holiday_rule(nth, month, n, weekday, actual_day);
+  }
+
+  //! holiday on the last \a weekday of \a month
+  static holiday_rule last_weekday(boost::date_time::weekdays weekday, unsigned month) {
+    if(weekday < boost::date_time::Sunday || weekday > boost::date_time::Saturday || month < 1 || month > 12)
+      throw std::logic_error("invalid weekday of the month");
+    return holiday_rule(last, month, 0, weekday, actual_day);
+  }
+
+  //! holiday \a days after Easter Sunday, or before it if negative
+  static holiday_rule easter_offset(int days) {
+    return holiday_rule(easter, 0, days, 0, actual_day);
+  }
+
+  //! the same rule, applied only in the years [first, last]
+  holiday_rule between(int first, int last) const {
+    holiday_rule result(*this);
+    result._first_year = first;
+    result._last_year = last;
+    return result;
+  }
+
+  //! date of the holiday set by the rule in \a year, not_a_date_time if there is none
+  /*! An observed holiday can fall in the previous or the following year.
+   */
+  boost::gregorian::date date_in(int year) const {
+    using namespace boost::gregorian;
+    if(year < _first_year || year > _last_year || year < 1400 || year > 9999)
+      return date(not_a_date_time);
+
+    switch(_kind) {
+    case fixed:
+      if(static_cast<unsigned>(_day) > gregorian_calendar::end_of_month_day(year, _month))
+        return date(not_a_date_time);
+      else {
+        const date d(year, _month, _day);
+        const int dow = d.day_of_week();
+        if(_observance == nearest_weekday && dow == boost::date_time::Saturday)
+          return shift(d, -1);
+        if(_observance != actual_day && dow == boost::date_time::Sunday)
+          return shift(d, 1);
+        if(_observance == following_monday && dow == boost::date_time::Saturday)
+          return shift(d, 2);
+        return d;
+      }
+    case nth: {
+      const date first(year, _month, 1);
+      const unsigned day = 1 + (_weekday - first.day_of_week() + 7) % 7 + 7 * (_day - 1);
+      if(day > gregorian_calendar::end_of_month_day(year, _month))
+        return date(not_a_date_time);
+      return date(year, _month, day);
+    }
+    case last: {
+      const date end = date(year, _month, 1).end_of_month();
+      return end - days((end.day_of_week() - _weekday + 7) % 7);
+    }
+    default:
+      return shift(easter_sunday(year), _day);
+    }
+  }
+
+  //! date of Easter Sunday in the Gregorian calendar
+  static boost::gregorian::date easter_sunday(int year) {
+    const int a = year % 19, b = year / 100, c = year % 100, d = b / 4, e = b % 4;
+    const int f = (b + 8) / 25, g = (b - f + 1) / 3, h = (19 * a + b - d - g + 15) % 30;
+    const int i = c / 4, k = c % 4, l = (32 + 2 * e + 2 * i - h - k) % 7, m = (a + 11 * h + 22 * l) / 451;
+    return boost::gregorian::date(year, (h + l - 7 * m + 114) / 31, (h + l - 7 * m + 114) % 31 + 1);
+  }
+
+private:
+  enum kind_type { fixed, nth, last, easter };
+
+  kind_type        _kind;
+  int              _month;
+  int              _day;          // day of the month, n for nth weekdays, offset for Easter
+  int              _weekday;
+  observance_type  _observance;
+  int              _first_year;
+  int              _last_year;
+
+  holiday_rule(kind_type kind, int month, int day, int weekday, observance_type observance) 
+    : _kind(kind), _month(month), _day(day), _weekday(weekday), _observance(observance), _first_year(1400), _last_year(9999) { }
+
+  //! \a d moved by \a n days, not_a_date_time if that leaves the range of dates
+  static boost::gregorian::date shift(const boost::gregorian::date& d, int n) {
+    const long dn = static_cast<long>(d.day_number()) + n;
+    if(dn < static_cast<long>(boost::gregorian::date(boost::gregorian::min_date_time).day_number()) || 
+       dn > static_cast<long>(boost::gregorian::date(boost::gregorian::max_date_time).day_number()))
+      return boost::gregorian::date(boost::gregorian::not_a_date_time);
+    return d + boost::gregorian::days(n);
+  }
+};
+
+
+//! Calendar generated from a set of holiday rules.
+/*! The rules are expanded into a per-year bitset for [first_year, last_year] when the calendar is built, 
+ *  other years are expanded the first time one of their days is queried. Safe for concurrent readers.
+ */
+struct holidays_from_rules : public holidays {
+  holidays_from_rules(const std::vector<holiday_rule>& rules, int first_year=0, int last_year=-1) 
+    : _rules(rules), _bitmap(std::bind(&holidays_from_rules::fill_year, std::cref(_rules), std::placeholders::_1, std::placeholders::_2)) { 
+    _bitmap.prepare(first_year, last_year);
+  }
+  bool is_holiday(const boost::gregorian::date& d) const {
+    return _bitmap.test(d);
+  }
+  void fill_holidays(const boost::gregorian::date& first, const boost::gregorian::date& last, uint64_t* bits) const {
+    _bitmap.fill(first, last, bits);
+  }
+private:
+  const std::vector<holiday_rule>  _rules;
+  detail::lazy_holidays_bitmap     _bitmap;
+
+  static void fill_year(const std::vector<holiday_rule>& rules, int year, uint64_t* bits) {
+    for(auto it=rules.begin(); it!=rules.end(); ++it)
+      for(int y=year-1; y<=year+1; ++y) {       // observed days can move across new year
+        const boost::gregorian::date d = it->date_in(y);
+        if(!d.is_special() && d.year() == year) {
+          const unsigned doy = d.day_of_year() - 1;
+          bits[doy >> 6] |= uint64_t(1) << (doy & 63);
+        }
+      }
+  }
+};
+
+
+//! Union of several calendars.
+/*! Nested composites and calendars given as fixed sets of dates are merged into a single bitmap
+ *  when the composite is built, only the remaining calendars are queried one by one.
+ */
 struct holidays_composite : public holidays {
-  holidays_composite(const std::vector<holidays_const_ptr>& holidays_array) : _array(holidays_array) { }
+  holidays_composite(const std::vector<holidays_const_ptr>& holidays_array) { 
+    for(auto it=holidays_array.begin(); it!=holidays_array.end(); ++it)
+      if(*it)
+        (*it)->flatten(_merged, _dynamic, *it);
+  }
   bool is_holiday(const boost::gregorian::date& d) const {
-    for(auto it=_array.begin(); it!=_array.end(); ++it)
+    if(_merged.test(d))
+      return true;
+    for(auto it=_dynamic.begin(); it!=_dynamic.end(); ++it)
       if((*it)->is_holiday(d))
         return true;
     return false;
   };
+  void fill_holidays(const boost::gregorian::date& first, const boost::gregorian::date& last, uint64_t* bits) const {
+    _merged.fill(first, last, bits);
+    for(auto it=_dynamic.begin(); it!=_dynamic.end(); ++it)
+      (*it)->fill_holidays(first, last, bits);
+  }
+  long count_holidays(const boost::gregorian::date& first, const boost::gregorian::date& last) const {
+    if(_dynamic.empty())
+      return _merged.count(first, last);
+    return holidays::count_holidays(first, last);
+  }
+  void flatten(detail::holidays_bitmap& bitmap, std::vector<holidays_const_ptr>& dynamic, const holidays_const_ptr& self) const {
+    bitmap.merge(_merged);
+    dynamic.insert(dynamic.end(), _dynamic.begin(), _dynamic.end());
+  }
 private:
-  std::vector<holidays_const_ptr> _array;
+  detail::holidays_bitmap         _merged;
+  std::vector<holidays_const_ptr> _dynamic;
 };
 
 
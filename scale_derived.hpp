@@ -9,24 +9,24 @@ namespace timescales {
 namespace detail {
   template<class Scale>
   struct helper {
-    inline static Scale* create(const ptime& p, time_zone_const_ptr tz) { 
-      return new Scale(p, 1, tz); 
+    inline static Scale create(const ptime& p, time_zone_const_ptr tz) { 
+      return Scale(p, 1, tz); 
     }
     
-    inline static Scale* create(const ptime& tm, const ptime& p, time_zone_const_ptr tz) { 
-      return new Scale(tm, p, 1, tz); 
+    inline static Scale create(const ptime& tm, const ptime& p, time_zone_const_ptr tz) { 
+      return Scale(tm, p, 1, tz); 
     }
     
-    inline static Scale* create(const local_date_time& tm, const local_date_time& start) { 
-      return new Scale(tm, start, 1); 
+    inline static Scale create(const local_date_time& tm, const local_date_time& start) { 
+      return Scale(tm, start, 1); 
     }
 
-    inline static Scale* create(const ptime& tm, const local_date_time& start) { 
-      return new Scale(tm, start, 1); 
+    inline static Scale create(const ptime& tm, const local_date_time& start) { 
+      return Scale(tm, start, 1); 
     }
 
-    inline static Scale* create(const local_date_time& p) { 
-      return new Scale(p, 1); 
+    inline static Scale create(const local_date_time& p) { 
+      return Scale(p, 1); 
     }
     
     inline static boost::gregorian::date date(const Scale* scale) { 
@@ -40,20 +40,20 @@ namespace detail {
 
   template<int64_t L, class C>
   struct helper<scale_simple<L,C> > {
-    inline static scale_simple<L,C>* create(const ptime& p, time_zone_const_ptr tz) { 
-      return new scale_simple<L,C>(p, 1); 
+    inline static scale_simple<L,C> create(const ptime& p, time_zone_const_ptr tz) { 
+      return scale_simple<L,C>(p, 1); 
     }
       
-    inline static scale_simple<L,C>* create(const ptime& tm, const ptime& p, time_zone_const_ptr tz) { 
-      return new scale_simple<L,C>(tm, p, 1); 
+    inline static scale_simple<L,C> create(const ptime& tm, const ptime& p, time_zone_const_ptr tz) { 
+      return scale_simple<L,C>(tm, p, 1); 
     }
       
-    inline static scale_simple<L,C>* create(const local_date_time& tm, const local_date_time& start) { 
-      return new scale_simple<L,C>(tm.utc_time(), start.utc_time(), 1); 
+    inline static scale_simple<L,C> create(const local_date_time& tm, const local_date_time& start) { 
+      return scale_simple<L,C>(tm.utc_time(), start.utc_time(), 1); 
     }
 
-    inline static scale_simple<L,C>* create(const local_date_time& p) { 
-      return new scale_simple<L,C>(p.utc_time(), 1); 
+    inline static scale_simple<L,C> create(const local_date_time& p) { 
+      return scale_simple<L,C>(p.utc_time(), 1); 
     }
       
     inline static boost::gregorian::date date(const scale_simple<L,C>* scale) { 
@@ -92,66 +92,61 @@ public:
   /*! \param start_ptime start anchor posix time
    *  \param freq   frequency
    *  \param tzname timezone name
+   *  \param selector selector of the valid base periods
    */
-  explicit scale_derived(const ptime& start, long frequency=1, time_zone_const_ptr tz=nullptr) : _frequency(frequency), _position(0) { 
+  explicit scale_derived(const ptime& start, long frequency=1, time_zone_const_ptr tz=nullptr, const Selector& selector=Selector()) 
+    : _frequency(frequency), _base(detail::helper<BaseScale>::create(start, tz)), _selector(selector), _position(0) { 
     if(start.is_special())
       throw std::logic_error("the start time cannot be a special value");
     if(_frequency <= 0)
       throw std::logic_error("frequency must be positive");
-    _base.reset(detail::helper<BaseScale>::create(start, tz));
-    Selector::snap_to_previous_value(_base.get());
+    _selector.snap_to_previous_value(&_base);
   }
 
-  explicit scale_derived(const local_date_time& start, long frequency=1) : _frequency(frequency), _position(0) { 
+  explicit scale_derived(const local_date_time& start, long frequency=1, const Selector& selector=Selector()) 
+    : _frequency(frequency), _base(detail::helper<BaseScale>::create(start)), _selector(selector), _position(0) { 
     if(start.is_special())
       throw std::logic_error("the start time cannot be a special value");
     if(_frequency <= 0)
       throw std::logic_error("frequency must be positive");
-    _base.reset(detail::helper<BaseScale>::create(start));
-    Selector::snap_to_previous_value(_base.get());
+    _selector.snap_to_previous_value(&_base);
   }
 
-  scale_derived(const ptime& tm, const ptime& start, long frequency=1, time_zone_const_ptr tz=nullptr) : _frequency(frequency) { 
+  scale_derived(const ptime& tm, const ptime& start, long frequency=1, time_zone_const_ptr tz=nullptr, const Selector& selector=Selector()) 
+    : _frequency(frequency), _base(detail::helper<BaseScale>::create(tm, start.is_special() ? tm : start, tz)), _selector(selector) { 
     if(tm.is_special())
       throw std::logic_error("the time to point to cannot be a special value");
     if(_frequency <= 0)
       throw std::logic_error("frequency must be positive");
-    if(start.is_special())
-      _base.reset(detail::helper<BaseScale>::create(tm, tm, tz));
-    else
-      _base.reset(detail::helper<BaseScale>::create(tm, start, tz));
-    Selector::snap_to_previous_value(_base.get());
-    _position = Selector::position(_base.get()) / _frequency;
+    _selector.snap_to_previous_value(&_base);
+    _position = _selector.position(&_base) / _frequency;
   }
   
-  scale_derived(const ptime& tm, const local_date_time& start, long frequency=1) : _frequency(frequency) { 
+  scale_derived(const ptime& tm, const local_date_time& start, long frequency=1, const Selector& selector=Selector()) 
+    : _frequency(frequency), _base(detail::helper<BaseScale>::create(tm, start.is_special() ? local_date_time(tm, start.zone()) : start)), _selector(selector) { 
     if(tm.is_special())
       throw std::logic_error("the time to point to cannot be a special value");
     if(_frequency <= 0)
       throw std::logic_error("frequency must be positive");
-    if(start.is_special())
-      _base.reset(detail::helper<BaseScale>::create(tm, local_date_time(tm, start.zone())));
-    else
-      _base.reset(detail::helper<BaseScale>::create(tm, start));
-    Selector::snap_to_previous_value(_base.get());
-    _position = Selector::position(_base.get()) / _frequency;
+    _selector.snap_to_previous_value(&_base);
+    _position = _selector.position(&_base) / _frequency;
   }
 
-  scale_derived(const local_date_time& tm, const local_date_time& start, long frequency=1) : _frequency(frequency) { 
+  scale_derived(const local_date_time& tm, const local_date_time& start, long frequency=1, const Selector& selector=Selector()) 
+    : _frequency(frequency), _base(detail::helper<BaseScale>::create(tm, start.is_special() ? tm : start)), _selector(selector) { 
     if(tm.is_special())
       throw std::logic_error("the time to point to cannot be a special value");
     if(_frequency <= 0)
       throw std::logic_error("frequency must be positive");
-    if(start.is_special())
-      _base.reset(detail::helper<BaseScale>::create(tm, tm));
-    else
-      _base.reset(detail::helper<BaseScale>::create(tm, start));
-    Selector::snap_to_previous_value(_base.get());
-    _position = Selector::position(_base.get()) / _frequency;
+    _selector.snap_to_previous_value(&_base);
+    _position = _selector.position(&_base) / _frequency;
   }
 
   //! copy constructor
-  scale_derived(const scale_type& rhs) : _frequency(rhs._frequency), _base(new BaseScale(*rhs._base)), _position(rhs._position) { }
+  scale_derived(const scale_type& rhs) : _frequency(rhs._frequency), _base(rhs._base), _selector(rhs._selector), _position(rhs._position) { }
+  
+  //! move constructor
+  scale_derived(scale_type&& rhs) noexcept : _frequency(rhs._frequency), _base(std::move(rhs._base)), _selector(std::move(rhs._selector)), _position(rhs._position) { }
   
   //! Shifted copy constructor
   /*! \param n      shift scale by \a n periods
@@ -159,20 +154,20 @@ public:
    */
   scale_derived(ssize_t n, const scale_type& rhs) : scale_derived((rhs + n).local_time(), rhs) { }
 
-  scale_derived(boost::gregorian::special_values, const scale_type& rhs) { 
+  scale_derived(boost::gregorian::special_values, const scale_type& rhs) : _base(rhs._base) { 
     throw std::logic_error("the start time cannot be a special value");
   }
   
   //! shifted copy constructor
-  scale_derived(const ptime& tm, const scale_type& rhs) : _frequency(rhs._frequency), _base(new BaseScale(tm, *rhs._base)) {
-    Selector::snap_to_previous_value(_base.get());
-    _position = Selector::position(_base.get()) / _frequency;
+  scale_derived(const ptime& tm, const scale_type& rhs) : _frequency(rhs._frequency), _base(tm, rhs._base), _selector(rhs._selector) {
+    _selector.snap_to_previous_value(&_base);
+    _position = _selector.position(&_base) / _frequency;
   }
   
   //! shifted copy constructor
-  scale_derived(const local_date_time& tm, const scale_type& rhs) : _frequency(rhs._frequency), _base(new BaseScale(tm, *rhs._base)) {
-    Selector::snap_to_previous_value(_base.get());
-    _position = Selector::position(_base.get()) / _frequency;
+  scale_derived(const local_date_time& tm, const scale_type& rhs) : _frequency(rhs._frequency), _base(tm, rhs._base), _selector(rhs._selector) {
+    _selector.snap_to_previous_value(&_base);
+    _position = _selector.position(&_base) / _frequency;
   }
 
   
@@ -181,8 +176,8 @@ public:
   //                   //  
 
   scale_type reference() const { 
-    auto sc = scale_type(_base->reference().utc_time(), *this);
-    Selector::snap_to_previous_value(sc._base.get());
+    auto sc = scale_type(_base.reference().utc_time(), *this);
+    _selector.snap_to_previous_value(&sc._base);
     return sc;
   }
 
@@ -194,8 +189,18 @@ public:
   //! assignment
   scale_type& operator= (const scale_type& rhs) { 
     _position = rhs._position;
-    _base.reset(new BaseScale(*rhs._base));
+    _base = rhs._base;
     _frequency = rhs._frequency;
+    _selector = rhs._selector;
+    return *this;
+  }
+  
+  //! move assignment
+  scale_type& operator= (scale_type&& rhs) noexcept { 
+    _position = rhs._position;
+    _base = std::move(rhs._base);
+    _frequency = rhs._frequency;
+    _selector = std::move(rhs._selector);
     return *this;
   }
   
@@ -206,7 +211,7 @@ public:
   
   //! prefix ++ operator
   scale_type& operator++ () { 
-    Selector::add(_base.get(), _frequency);
+    _selector.add(&_base, _frequency);
     ++_position;
     return *this; 
   }
@@ -220,7 +225,7 @@ public:
   
   //! prefix -- operator
   scale_type& operator-- () { 
-    Selector::add(_base.get(), -_frequency);
+    _selector.add(&_base, -_frequency);
     --_position;
     return *this; 
   }
@@ -234,7 +239,7 @@ public:
   
   //! in-place + operator
   scale_type& operator+= (unsigned long i) { 
-    Selector::add(_base.get(), _frequency * static_cast<long>(i));
+    _selector.add(&_base, _frequency * static_cast<long>(i));
     _position += i;
     return *this;
   }
@@ -247,7 +252,7 @@ public:
   
   //! in-place - operator
   scale_type& operator-= (unsigned long i) { 
-    Selector::add(_base.get(), -_frequency * static_cast<long>(i));
+    _selector.add(&_base, -_frequency * static_cast<long>(i));
     _position -= i;
     return *this;
 
@@ -266,7 +271,7 @@ public:
   
   //! equality operator
   bool operator== (const scale_type& rhs) const {
-    return _frequency == rhs._frequency && *_base == *rhs._base;
+    return _frequency == rhs._frequency && _selector == rhs._selector && _base == rhs._base;
   }
   
   //! inequality operator
@@ -295,11 +300,11 @@ public:
   //              //
   
   local_date_time local_time() const override {
-    return _base->local_time();
+    return _base.local_time();
   }
   
   ptime utc_time() const override { 
-    return _base->utc_time();
+    return _base.utc_time();
   }
   
   
@@ -307,10 +312,27 @@ public:
   // string representation //
   //                       //
   
+  //! writes the label of the current period to \a out, max_label_size chars long, returns its length
+  size_t label(char* out) const { 
+    typename Labeler::cursor_type cursor;
+    return write_label(cursor, out, label_time(), (*this+1).label_time());
+  }
+
+  //! time given to the labeler for the current period
+  auto label_time() const -> decltype(detail::helper<BaseScale>::time(nullptr)) {
+    return detail::helper<BaseScale>::time(&_base);
+  }
+
+  //! writes the label of the period from \a t to \a next to \a out, returns its length
+  template<class T>
+  static size_t write_label(typename Labeler::cursor_type& cursor, char* out, const T& t, const T& next) {
+    return Labeler::write_with(cursor, out, t, next-boost::posix_time::time_duration(0,0,0,1));
+  }
+
   //! string representation
-  std::string to_string() const { 
-    auto tmp(*this+1);
-    return Labeler::str(detail::helper<BaseScale>::time(_base.get()), detail::helper<BaseScale>::time(tmp._base.get())-boost::posix_time::time_duration(0,0,0,1)); 
+  std::string to_string() const {
+    char buffer[max_label_size];
+    return std::string(buffer, label(buffer));
   }
 
   //! ostream operator <<
@@ -321,165 +343,193 @@ public:
   
 private:
   long                          _frequency;
-  std::unique_ptr<BaseScale>    _base;
+  BaseScale                     _base;
+  Selector                      _selector;
   long                          _position;
 };
 
 
+namespace detail {
+
+//! Day of the week arithmetic for the days selected by a 7-bit mask (bit 0 is Sunday, bit 6 is Saturday).
+/*! Days are counted in base scale periods, which must be consecutive calendar days. 
+ *  This keeps the arithmetic exact across DST changes on a days_scale, where a period is not always 24h long.
+ */
+struct weekmask_arithmetic {
+  //! number of selected days in a week
+  static long count(unsigned mask) {
+    return popcount(mask & 0x7f);
+  }
+
+  //! number of selected days in the week before \a dow
+  static long count_before(unsigned mask, int dow) {
+    return popcount(mask & ((1u << dow) - 1));
+  }
+  
+  //! the \a r-th selected day of the week, \a r in [0, count(mask))
+  static int nth(unsigned mask, long r) {
+    uint64_t m = mask & 0x7f;
+    for(; r>0; --r)
+      m &= m - 1;
+    return lowest_bit(m);
+  }
+  
+  //! true if \a dow is selected
+  static bool is_valid(unsigned mask, int dow) {
+    return (mask >> dow) & 1;
+  }
+
+  //! number of days to go back from \a dow to reach a selected day
+  static int back(unsigned mask, int dow) {
+    int k = 0;
+    while(!is_valid(mask, (dow - k + 7) % 7))
+      ++k;
+    return k;
+  }
+  
+  //! number of days to add to a selected day \a dow to move \a n selected days
+  static long days_to_add(unsigned mask, int dow, long n) {
+    long k = count_before(mask, dow) + n;
+    long q = floor_div(k, count(mask));
+    return 7 * q + nth(mask, k - q * count(mask)) - dow;
+  }
+
+  //! number of selected days in [0, d), day 0 being a Sunday
+  static long rank(unsigned mask, long d) {
+    long q = floor_div(d, 7);
+    return count(mask) * q + count_before(mask, static_cast<int>(d - 7 * q));
+  }
+
+  static long floor_div(long a, long b) {
+    return a / b - (a % b < 0);
+  }
+};
+
+
+//! Stepping through the days of the week selected by a mask.
 template<class BaseScale>
-struct weekdays_selector {
-  static void snap_to_previous_value(BaseScale* scale) {
-    switch( static_cast<int>(detail::helper<BaseScale>::date(scale).day_of_week()) ) {
-      case 0: // Sunday
-        *scale -= 2;
-        break;
-      case 6: // Saturday
-        --*scale;
-        break;
-      default:
-        break;
-    }
+struct weekmask_stepping {
+  static void snap_to_previous_value(unsigned mask, BaseScale* scale) {
+    *scale -= weekmask_arithmetic::back(mask, day_of_week(scale));
   }
   
-  static long position(const BaseScale* scale) {
-//     std::cout << std::endl << std::endl;
-//     std::cout << detail::helper<BaseScale>::date(scale).day_of_week() << std::endl;
-//     long guess = 5 * (scale->value() / 7) - 5;         // 5 weekdays in each week. 
-//     BaseScale helper_scale = scale->reference();
-//     snap_to_previous_value(&helper_scale);
-//     helper_scale  += 7 * (guess / 5); // start with our guess -- to get here we already snapped to a valid date, so helper must be valid
-//     std::cout << detail::helper<BaseScale>::date(&helper_scale).day_of_week() << std::endl;
-//     while(helper_scale.value() < scale->value()) {
-//     std::cout << "  " << detail::helper<BaseScale>::date(&helper_scale).day_of_week() << " " << helper_scale.value() << " " << guess << " | " << scale->value() << std::endl;
-//       ++guess;                          // advance one day
-//       ++helper_scale;
-//       if(!is_valid(&helper_scale))       // make sure we are not on a Saturday. If so add 2 days to end up on Monday
-//         helper_scale += 2;
-//     }
-//     std::cout << "  " << helper_scale.value() << " " << scale->value() << std::endl;
-//     return guess;
-    
-    long guess = 0;
-    BaseScale helper_scale = scale->reference();
-    snap_to_previous_value(&helper_scale);
-    while(helper_scale.value() < scale->value()) {
-      ++helper_scale;
-      while(!is_valid(&helper_scale)) ++helper_scale;
-      ++guess;
-    }
-    while(helper_scale.value() > scale->value()) {
-      --helper_scale;
-      while(!is_valid(&helper_scale)) --helper_scale;
-      --guess;
-    }
-    return guess;
+  static long position(unsigned mask, const BaseScale* scale) {
+    // the reference is at value 0, snapped back to a selected day
+    long v = scale->value();
+    long dow0 = (day_of_week(scale) - v % 7 + 7) % 7;
+    long z = -weekmask_arithmetic::back(mask, static_cast<int>(dow0));
+    return weekmask_arithmetic::rank(mask, v + dow0) - weekmask_arithmetic::rank(mask, z + dow0);
   }
 
-  static void add(BaseScale* scale, long n) {
-//     // add full weeks + rest
-//     *scale += 7 * (n / 5) + (n % 5);
-//     // add 2 if we ended on a weekend
-//     if(n < 0) {
-//       while(!is_valid(scale))
-//         --(*scale);
-//     }
-//     else {
-//       while(!is_valid(scale))
-//         ++(*scale);
-//     }
-    if(n>0) {
-      for(long i=0; i<n; ++i) {
-        ++(*scale);
-        while(!is_valid(scale))
-          ++(*scale);
-      }
-    }
-    else if(n<0) {
-      for(long i=0; i>n; --i) {
-        --(*scale);
-        while(!is_valid(scale))
-          --(*scale);
-      }
-    }
+  static void add(unsigned mask, BaseScale* scale, long n) {
+    if(n == 0)
+      return;
+    long days = weekmask_arithmetic::days_to_add(mask, day_of_week(scale), n);
+    if(days > 0)
+      *scale += static_cast<unsigned long>(days);
+    else if(days < 0)
+      *scale -= static_cast<unsigned long>(-days);
   }
   
 private:
-  static bool is_valid(BaseScale* scale) {
-    return static_cast<short>(detail::helper<BaseScale>::date(scale).day_of_week()) % 6;
+  static int day_of_week(const BaseScale* scale) {
+    return static_cast<int>(detail::helper<BaseScale>::date(scale).day_of_week());
   }
 };
 
 
-template<class BaseScale>
-struct weekend_days_selector {
+//! Selector for a mask of days of the week known at compile time.
+template<class BaseScale, unsigned Mask>
+struct fixed_weekmask_selector {
+  static_assert((Mask & 0x7f) != 0, "at least one day of the week must be selected");
+  
   static void snap_to_previous_value(BaseScale* scale) {
-    *scale -= (static_cast<int>(detail::helper<BaseScale>::date(scale).day_of_week()) % 6);
+    weekmask_stepping<BaseScale>::snap_to_previous_value(Mask, scale);
   }
   
   static long position(const BaseScale* scale) {
-//     long guess = 2 * (scale->value() / 7) - 2;  // 2 weekend days in each week. Minus one week, to handle corner cases
-//     BaseScale helper_scale = scale->reference();
-//     helper_scale += 7 * (guess / 2);      // start with our guess
-//     while(helper_scale.value() < scale->value()) {
-//       ++guess;                          // advance one day
-//       ++helper_scale;
-//       if(!is_valid(&helper_scale))       // make sure we are not on a Monday. If so add 5 days to end up on Saturday
-//         helper_scale += 5;
-//     }
-//     return guess;
-    long guess = 0;
-    BaseScale helper_scale = scale->reference();
-    snap_to_previous_value(&helper_scale);
-    while(helper_scale.value() < scale->value()) {
-      ++helper_scale;
-      while(!is_valid(&helper_scale)) ++helper_scale;
-      ++guess;
-    }
-    while(helper_scale.value() > scale->value()) {
-      --helper_scale;
-      while(!is_valid(&helper_scale)) --helper_scale;
-      --guess;
-    }
-    return guess;
+    return weekmask_stepping<BaseScale>::position(Mask, scale);
   }
 
   static void add(BaseScale* scale, long n) {
-//     // add full weeks + rest
-//     *scale += 7 * (n / 2) + (n % 2);
-//     // add 5 if we ended on a Monday
-//     if(n < 0) {
-//       while(!is_valid(scale))
-//         --(*scale);
-//     }
-//     else {
-//       while(!is_valid(scale))
-//         ++(*scale);
-//     }
-//   }
-    if(n>0) {
-      for(long i=0; i<n; ++i) {
-        ++(*scale);
-        while(!is_valid(scale))
-          ++(*scale);
-      }
-    }
-    else if(n<0) {
-      for(long i=0; i>n; --i) {
-        --(*scale);
-        while(!is_valid(scale))
-          --(*scale);
-      }
-    }
+    weekmask_stepping<BaseScale>::add(Mask, scale, n);
   }
+
+  bool operator== (const fixed_weekmask_selector&) const { return true; }
+};
+
+}
+
+
+//! Days of the week, to be combined into masks for a weekmask_selector
+namespace weekmask {
+  enum : unsigned {
+    sunday    = 1 << 0,
+    monday    = 1 << 1,
+    tuesday   = 1 << 2,
+    wednesday = 1 << 3,
+    thursday  = 1 << 4,
+    friday    = 1 << 5,
+    saturday  = 1 << 6,
+    weekdays  = monday | tuesday | wednesday | thursday | friday,
+    weekend   = saturday | sunday
+  };
+}
+
+
+//! Selects Monday to Friday
+template<class BaseScale>
+struct weekdays_selector : detail::fixed_weekmask_selector<BaseScale, weekmask::weekdays> { };
+
+
+//! Selects Saturday and Sunday
+template<class BaseScale>
+struct weekend_days_selector : detail::fixed_weekmask_selector<BaseScale, weekmask::weekend> { };
+
+
+//! Selects the days of the week set in a mask.
+/*! The mask is fixed at compile time when \a Mask is given, e.g. 
+ *  weekmask_selector<days_scale, weekmask::sunday | weekmask::monday | weekmask::tuesday | weekmask::wednesday | weekmask::thursday>.
+ */
+template<class BaseScale, int Mask=-1>
+struct weekmask_selector : detail::fixed_weekmask_selector<BaseScale, static_cast<unsigned>(Mask)> {
+  static_assert(Mask > 0 && Mask < 128, "the mask must be a combination of weekmask values");
+};
+
+
+//! Selects the days of the week set in a mask given at runtime.
+/*! Pass an instance to the scale_derived constructors, e.g. 
+ *  scale_derived<days_scale, weekmask_selector<days_scale> >(p, 1, tz, weekmask_selector<days_scale>(weekmask::weekdays | weekmask::saturday)).
+ *  Defaults to Monday to Friday.
+ */
+template<class BaseScale>
+struct weekmask_selector<BaseScale, -1> {
+  weekmask_selector() : _mask(weekmask::weekdays) { }
   
-private:
-  static bool is_valid(BaseScale* scale) {
-    return static_cast<short>(detail::helper<BaseScale>::date(scale).day_of_week()) % 6 == 0;
+  explicit weekmask_selector(unsigned mask) : _mask(mask) {
+    if((mask & 0x7f) == 0 || (mask & ~0x7fu) != 0)
+      throw std::logic_error("the mask must select at least one day of the week and nothing else");
   }
-};
+  
+  unsigned mask() const { return _mask; }
 
+  void snap_to_previous_value(BaseScale* scale) const {
+    detail::weekmask_stepping<BaseScale>::snap_to_previous_value(_mask, scale);
+  }
+  
+  long position(const BaseScale* scale) const {
+    return detail::weekmask_stepping<BaseScale>::position(_mask, scale);
+  }
 
+  void add(BaseScale* scale, long n) const {
+    detail::weekmask_stepping<BaseScale>::add(_mask, scale, n);
+  }
+  
+  bool operator== (const weekmask_selector& rhs) const { return _mask == rhs._mask; }
 
+private:
+  unsigned _mask;
+};
 
 
 }
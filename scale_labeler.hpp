@@ -6,121 +6,299 @@
 namespace timescales {
 
 namespace detail {
-  
+
   template<typename T=int>
   struct _conversions {
     static const ptime& ptime_from_time(const ptime& t) { return t; }
-    static ptime ptime_from_time(const local_date_time& t) { return t.local_time(); }  
+    static ptime ptime_from_time(const local_date_time& t) { return t.local_time(); }
   };
-  
+
   typedef _conversions<>        conversions;
+
+  //! writes the \a width lowest decimal digits of \a v to \a out, returns the end of the output
+  inline char* write_digits(char* out, unsigned long v, int width) {
+    for(int i=width-1; i>=0; --i, v/=10)
+      out[i] = static_cast<char>('0' + v % 10);
+    return out + width;
+  }
+
+  //! writes \a v in decimal without padding, returns the end of the output
+  inline char* write_number(char* out, long v) {
+    if(v < 0)
+      *out++ = '-';
+    unsigned long u = v < 0 ? -static_cast<unsigned long>(v) : static_cast<unsigned long>(v);
+    int width = 1;
+    for(unsigned long x=u; x>=10; x/=10)
+      ++width;
+    return write_digits(out, u, width);
+  }
+
+  //! writes the nul-terminated \a s, returns the end of the output
+  inline char* write_chars(char* out, const char* s) {
+    while(*s)
+      *out++ = *s++;
+    return out;
+  }
+
+  //! english abbreviation of the month \a m, 1 for January
+  inline const char* month_abbreviation(int m) {
+    static const char* const names[] = { "Jan", "Feb", "Mar", "Apr", "May", "Jun", "Jul", "Aug", "Sep", "Oct", "Nov", "Dec" };
+    return names[m - 1];
+  }
+
+  //! english abbreviation of the day of the week \a wd, 0 for Sunday
+  inline const char* weekday_abbreviation(int wd) {
+    static const char* const names[] = { "Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat" };
+    return names[wd];
+  }
+
+  //! writes \a d as YYYYMMDD, returns the end of the output
+  inline char* write_iso_date(char* out, const boost::gregorian::date& d) {
+    boost::gregorian::date::ymd_type ymd = d.year_month_day();
+    out = write_digits(out, ymd.year, 4);
+    out = write_digits(out, ymd.month, 2);
+    return write_digits(out, ymd.day, 2);
+  }
+
+  //! writes \a p as boost::posix_time::to_iso_string does, returns the end of the output
+  inline char* write_iso_time(char* out, const ptime& p) {
+    boost::posix_time::time_duration td(p.time_of_day());
+    out = write_iso_date(out, p.date());
+    *out++ = 'T';
+    out = write_digits(out, td.hours(), 2);
+    out = write_digits(out, td.minutes(), 2);
+    out = write_digits(out, td.seconds(), 2);
+    if(td.fractional_seconds() != 0) {
+      *out++ = '.';
+      out = write_digits(out, td.fractional_seconds(), boost::posix_time::time_duration::num_fractional_digits());
+    }
+    return out;
+  }
+
+  //! writes the zone suffix of local_date_time::to_iso_string for \a ldt, returns the end of the output
+  /*! Z without a zone, and the offset of the zone otherwise, signed as local_date_time does: +HHMM when 
+   *  the local time is behind utc.
+   */
+  inline char* write_iso_offset(char* out, const local_date_time& ldt) {
+    if(!ldt.zone()) {
+      *out++ = 'Z';
+      return out;
+    }
+    const boost::posix_time::time_duration offset(ldt.utc_time() - ldt.local_time());
+    const long minutes = offset.is_negative() ? -offset.total_seconds() / 60 : offset.total_seconds() / 60;
+    *out++ = offset.is_negative() ? '-' : '+';
+    out = write_digits(out, minutes / 60, 2);
+    return write_digits(out, minutes % 60, 2);
+  }
+
+  //! writes \a ldt as local_date_time::to_iso_string does, returns the end of the output
+  inline char* write_iso_time(char* out, const local_date_time& ldt) {
+    return write_iso_offset(write_iso_time(out, ldt.local_time()), ldt);
+  }
+
+  //! Civil date of the last date seen, updated with a subtraction while the dates stay in the same month.
+  class civil_cursor {
+  public:
+    civil_cursor() : _first(1), _last(0), _year(0), _month(0) { }
+
+    //! sets \a year, \a month, \a day and \a day_of_week (0 for Sunday) to those of \a d
+    void operator() (const boost::gregorian::date& d, int& year, int& month, int& day, int& day_of_week) {
+      const unsigned long n = d.day_number();
+      if(n < _first || n > _last) {
+        boost::gregorian::date::ymd_type ymd = d.year_month_day();
+        _year = ymd.year;
+        _month = ymd.month;
+        _first = n - (ymd.day - 1);
+        _last = _first + boost::gregorian::gregorian_calendar::end_of_month_day(ymd.year, ymd.month) - 1;
+      }
+      year = _year;
+      month = _month;
+      day = static_cast<int>(n - _first) + 1;
+      day_of_week = static_cast<int>((n + 1) % 7);
+    }
+
+  private:
+    unsigned long  _first;
+    unsigned long  _last;
+    int            _year;
+    int            _month;
+  };
+
+  //! Base of the labelers, which write the label of a period to a buffer of max_label_size chars.
+  /*! Labelers working on dates hide write_with() with a version using the cursor, shared by the
+   *  consecutive labels of timescale::labels().
+   */
+  template<class Labeler>
+  struct labeler {
+    typedef civil_cursor cursor_type;
+
+    //! writes the label of the period from \a start to \a end to \a out, returns its length
+    template<typename T>
+    static size_t write_with (cursor_type&, char* out, const T& start, const T& end) {
+      return Labeler::write(out, start, end);
+    }
+
+    //! label of the period from \a start to \a end
+    template<typename T>
+    static std::string str (const T& start, const T& end) {
+      char buffer[max_label_size];
+      return std::string(buffer, Labeler::write(buffer, start, end));
+    }
+  };
 }
-  
-struct years_labeler {
+
+struct years_labeler : detail::labeler<years_labeler> {
   template<typename T>
-  static std::string str (const T& start, const T& end) {
-    std::ostringstream s;
-    s << detail::conversions::ptime_from_time(start).date().year();
-    return s.str();
+  static size_t write (char* out, const T& start, const T& end) {
+    return detail::write_number(out, detail::conversions::ptime_from_time(start).date().year()) - out;
   }
 };
 
-struct months_labeler {
+struct months_labeler : detail::labeler<months_labeler> {
+  template<typename T>
+  static size_t write (char* out, const T& start, const T& end) {
+    cursor_type cursor;
+    return write_with(cursor, out, start, end);
+  }
+
   template<typename T>
-  static std::string str (const T& start, const T& end) {
-    std::ostringstream s;
-    s << detail::conversions::ptime_from_time(start).date().month() << " " << detail::conversions::ptime_from_time(start).date().year();
-    return s.str();
+  static size_t write_with (cursor_type& cursor, char* out, const T& start, const T& end) {
+    int year, month, day, day_of_week;
+    cursor(detail::conversions::ptime_from_time(start).date(), year, month, day, day_of_week);
+    char* p = detail::write_chars(out, detail::month_abbreviation(month));
+    *p++ = ' ';
+    return detail::write_number(p, year) - out;
   }
 };
 
-struct weeks_labeler {
+struct weeks_labeler : detail::labeler<weeks_labeler> {
   template<typename T>
-  static std::string str (const T& start, const T& end) {
-    std::ostringstream s;
+  static size_t write (char* out, const T& start, const T& end) {
     boost::gregorian::date d(detail::conversions::ptime_from_time(start).date());
     int week_number = d.week_number();
-    if( d.month() == 1 && week_number > 50 )
-      s << (d.year()-1) << "W" <<  week_number;
-    else
-      s << d.year() << "W" <<  week_number;
-    return s.str();
+    int year = d.year();
+    char* p = detail::write_number(out, d.month() == 1 && week_number > 50 ? year - 1 : year);
+    *p++ = 'W';
+    return detail::write_number(p, week_number) - out;
   }
 };
 
-struct date_labeler {
+struct date_labeler : detail::labeler<date_labeler> {
   template<typename T>
-  static std::string str (const T& start, const T& end) {
-    return boost::gregorian::to_iso_string(detail::conversions::ptime_from_time(start).date());
+  static size_t write (char* out, const T& start, const T& end) {
+    cursor_type cursor;
+    return write_with(cursor, out, start, end);
+  }
+
+  template<typename T>
+  static size_t write_with (cursor_type& cursor, char* out, const T& start, const T& end) {
+    int year, month, day, day_of_week;
+    cursor(detail::conversions::ptime_from_time(start).date(), year, month, day, day_of_week);
+    char* p = detail::write_digits(out, year, 4);
+    p = detail::write_digits(p, month, 2);
+    return detail::write_digits(p, day, 2) - out;
   }
 };
 
-struct weekdays_labeler {
+struct weekdays_labeler : detail::labeler<weekdays_labeler> {
   template<typename T>
-  static std::string str (const T& start, const T& end) {
-    std::ostringstream s;
-    boost::gregorian::date d(detail::conversions::ptime_from_time(start).date());
-    s << d.day_of_week() << ", " << boost::gregorian::to_simple_string(d);
-    return s.str();
+  static size_t write (char* out, const T& start, const T& end) {
+    cursor_type cursor;
+    return write_with(cursor, out, start, end);
+  }
+
+  template<typename T>
+  static size_t write_with (cursor_type& cursor, char* out, const T& start, const T& end) {
+    int year, month, day, day_of_week;
+    cursor(detail::conversions::ptime_from_time(start).date(), year, month, day, day_of_week);
+    char* p = detail::write_chars(out, detail::weekday_abbreviation(day_of_week));
+    p = detail::write_chars(p, ", ");
+    p = detail::write_digits(p, year, 4);
+    *p++ = '-';
+    p = detail::write_chars(p, detail::month_abbreviation(month));
+    *p++ = '-';
+    return detail::write_digits(p, day, 2) - out;
   }
 };
 
-struct hours_labeler {
-  static std::string str (const ptime& start, const ptime& end) {
-    return boost::posix_time::to_iso_string(ptime(start.date(), boost::posix_time::time_duration(start.time_of_day().hours(), 0, 0)));
+struct hours_labeler : detail::labeler<hours_labeler> {
+  static size_t write (char* out, const ptime& start, const ptime& end) {
+    return detail::write_iso_time(out, ptime(start.date(), boost::posix_time::time_duration(start.time_of_day().hours(), 0, 0))) - out;
   }
 
-  static std::string str (const local_date_time& start, const local_date_time& end) {
+  static size_t write (char* out, const local_date_time& start, const local_date_time& end) {
     boost::posix_time::time_duration td(start.local_time().time_of_day());
-    return (start - boost::posix_time::time_duration(0,td.minutes(),td.seconds(),td.fractional_seconds())).to_iso_string();
-  }  
+    return detail::write_iso_time(out, start - boost::posix_time::time_duration(0,td.minutes(),td.seconds(),td.fractional_seconds())) - out;
+  }
 };
 
-struct minutes_labeler {
-  static std::string str (const ptime& start, const ptime& end) {
+struct minutes_labeler : detail::labeler<minutes_labeler> {
+  static size_t write (char* out, const ptime& start, const ptime& end) {
     boost::posix_time::time_duration td(start.time_of_day());
-    return boost::posix_time::to_iso_string(ptime(start.date(), boost::posix_time::time_duration(td.hours(), td.minutes(), 0)));
+    return detail::write_iso_time(out, ptime(start.date(), boost::posix_time::time_duration(td.hours(), td.minutes(), 0))) - out;
   }
-  
-  static std::string str (const local_date_time& start, const local_date_time& end) {
+
+  static size_t write (char* out, const local_date_time& start, const local_date_time& end) {
     boost::posix_time::time_duration td(start.local_time().time_of_day());
-    return (start - boost::posix_time::time_duration(0,0,td.seconds(),td.fractional_seconds())).to_iso_string();
-  }  
+    return detail::write_iso_time(out, start - boost::posix_time::time_duration(0,0,td.seconds(),td.fractional_seconds())) - out;
+  }
 };
 
-struct seconds_labeler {
-  static std::string str (const ptime& start, const ptime& end) {
+struct seconds_labeler : detail::labeler<seconds_labeler> {
+  static size_t write (char* out, const ptime& start, const ptime& end) {
     boost::posix_time::time_duration td(start.time_of_day());
-    return boost::posix_time::to_iso_string(ptime(start.date(), boost::posix_time::time_duration(td.hours(), td.minutes(), td.seconds())));
+    return detail::write_iso_time(out, ptime(start.date(), boost::posix_time::time_duration(td.hours(), td.minutes(), td.seconds()))) - out;
   }
 
-  static std::string str (const local_date_time& start, const local_date_time& end) {
+  static size_t write (char* out, const local_date_time& start, const local_date_time& end) {
     boost::posix_time::time_duration td(start.local_time().time_of_day());
-    return (start - boost::posix_time::time_duration(0,0,0,td.fractional_seconds())).to_iso_string();
-  }  
+    return detail::write_iso_time(out, start - boost::posix_time::time_duration(0,0,0,td.fractional_seconds())) - out;
+  }
 };
 
-struct milliseconds_labeler {
-  static std::string str (const ptime& start, const ptime& end) {
+struct milliseconds_labeler : detail::labeler<milliseconds_labeler> {
+  static size_t write (char* out, const ptime& start, const ptime& end) {
     boost::posix_time::time_duration td(start.time_of_day());
-    return boost::posix_time::to_iso_string(start - boost::posix_time::time_duration(0,0,0,td.fractional_seconds() % 1000));
+    return detail::write_iso_time(out, start - boost::posix_time::time_duration(0,0,0,td.fractional_seconds() % 1000)) - out;
   }
 
-  static std::string str (const local_date_time& start, const local_date_time& end) {
+  static size_t write (char* out, const local_date_time& start, const local_date_time& end) {
     boost::posix_time::time_duration td(start.local_time().time_of_day());
-    return (start - boost::posix_time::time_duration(0,0,0,td.fractional_seconds() % 1000)).to_iso_string();
+    return detail::write_iso_time(out, start - boost::posix_time::time_duration(0,0,0,td.fractional_seconds() % 1000)) - out;
+  }
+};
+
+struct microseconds_labeler : detail::labeler<microseconds_labeler> {
+  static size_t write (char* out, const ptime& start, const ptime& end) {
+    return detail::write_iso_time(out, start) - out;
+  }
+
+  static size_t write (char* out, const local_date_time& start, const local_date_time& end) {
+    return detail::write_iso_time(out, start) - out;
   }
 };
 
-struct microseconds_labeler {
-  static std::string str (const ptime& start, const ptime& end) {
-    return boost::posix_time::to_iso_string(start);
+struct nanoseconds_labeler : detail::labeler<nanoseconds_labeler> {
+  //! \a start and \a end in nanoseconds since 1970-01-01, written with nine fractional digits when not whole seconds
+  static size_t write (char* out, int64_t start, int64_t end) {
+    const int64_t seconds = (start >= 0 ? start : start - 999999999) / 1000000000;
+    const int64_t fraction = start - seconds * 1000000000;
+    char* p = detail::write_iso_time(out, detail::from_epoch_microseconds(seconds * 1000000));
+    if(fraction != 0) {
+      *p++ = '.';
+      p = detail::write_digits(p, fraction, 9);
+    }
+    return p - out;
+  }
+
+  static size_t write (char* out, const ptime& start, const ptime& end) {
+    return write(out, detail::epoch_nanoseconds(start), detail::epoch_nanoseconds(end));
   }
 
-  static std::string str (const local_date_time& start, const local_date_time& end) {
-    return start.to_iso_string();
+  static size_t write (char* out, const local_date_time& start, const local_date_time& end) {
+    const size_t n = write(out, detail::epoch_nanoseconds(start.local_time()), detail::epoch_nanoseconds(end.local_time()));
+    return detail::write_iso_offset(out + n, start) - out;
   }
-  
 };
 
 
@@ -0,0 +1,358 @@
+#ifndef TIMESCALES_SCALE_NANOSECONDS_HPP
+#define TIMESCALES_SCALE_NANOSECONDS_HPP
+
+#include "timescale.hpp"
+#include "scale_labeler.hpp"
+#include "scale_simple.hpp"
+
+namespace timescales {
+
+namespace detail {
+
+//! Labels of a scale_nanoseconds, written by \a Labeler from the times of their periods rounded to the microsecond.
+template<class Labeler>
+struct nanoseconds_label {
+  static size_t write(typename Labeler::cursor_type& cursor, char* out, int64_t t, int64_t next) {
+    return Labeler::write_with(cursor, out, from_epoch_nanoseconds(t), from_epoch_nanoseconds(next - 1));
+  }
+};
+
+//! The nanoseconds_labeler writes the nanoseconds themselves.
+template<>
+struct nanoseconds_label<nanoseconds_labeler> {
+  static size_t write(nanoseconds_labeler::cursor_type&, char* out, int64_t t, int64_t next) {
+    return nanoseconds_labeler::write(out, t, next - 1);
+  }
+};
+
+}
+
+
+//! The scale_nanoseconds class defines a scale_simple on times in nanoseconds since 1970-01-01.
+/*! The anchor, the periods and the times given to the nanoseconds interface are plain int64_t nanoseconds,
+ *  which cover the years 1678 to 2261. The ptime and microseconds interface of the other scales is kept:
+ *  the times of the periods are rounded down to the microsecond, and the microseconds are converted exactly.
+ *  Times outside of the covered years given to that interface throw std::out_of_range.
+ */
+template<int64_t Multiplier, class Labeler>
+class scale_nanoseconds : public detail::timescale<scale_nanoseconds<Multiplier, Labeler> > {
+
+  static_assert(Multiplier > 0, "Multiplier in a scale_nanoseconds must be positive.");
+
+public:
+
+  //          //
+  // typedefs //
+  //          //
+
+  typedef scale_nanoseconds<Multiplier, Labeler>                      scale_type;
+  typedef detail::timescale<scale_nanoseconds<Multiplier, Labeler> >  scale_type_base;
+  typedef Labeler                                                     labeler_type;
+
+
+  //              //
+  // constructors //
+  //              //
+
+  //! Constructor
+  /*! \param start  anchor, in nanoseconds since 1970-01-01
+   *  \param freq   frequency
+   */
+  scale_nanoseconds(int64_t start, long freq) : _frequency(freq), _start(start), _position(0) {
+    if(_frequency <= 0)
+      throw std::logic_error("frequency must be positive");
+  }
+
+  //! Constructor
+  /*! \param ns     shift scale to this time, in nanoseconds since 1970-01-01
+   *  \param start  anchor, in nanoseconds since 1970-01-01
+   *  \param freq   frequency
+   */
+  scale_nanoseconds(int64_t ns, int64_t start, long freq) : _frequency(freq), _start(start) {
+    if(_frequency <= 0)
+      throw std::logic_error("frequency must be positive");
+    _position = (ns - _start) / (_frequency * Multiplier);  // integer division
+  }
+
+  //! Constructor
+  /*! \param start  anchor
+   *  \param freq   frequency
+   */
+  scale_nanoseconds(const ptime& start, long freq) : _frequency(freq), _start(anchor(start)), _position(0) {
+    if(_frequency <= 0)
+      throw std::logic_error("frequency must be positive");
+  }
+
+  scale_nanoseconds(boost::gregorian::special_values, long) : _frequency(0), _start(0), _position(0) {
+    throw std::logic_error("the start time cannot be a special value");
+  }
+
+  //! Constructor
+  /*! \param ts     shift scale to this ptime
+   *  \param start  anchor
+   *  \param freq   frequency
+   */
+  explicit scale_nanoseconds(const ptime& ts, const ptime& start=boost::posix_time::special_values::not_a_date_time, long freq=1) : _frequency(freq) {
+    if(ts.is_special())
+      throw std::logic_error("the time to point to cannot be a special value");
+    _start = detail::epoch_nanoseconds(start.is_special() ? ts : start);
+    if(_frequency <= 0)
+      throw std::logic_error("frequency must be positive");
+    _position = (detail::epoch_nanoseconds(ts) - _start) / (_frequency * Multiplier);  // integer division
+  }
+
+  //! Copy constructor
+  /*! \param other  other instance
+   */
+  scale_nanoseconds(const scale_type& other) : _frequency(other._frequency), _start(other._start), _position(other._position) { }
+
+  //! Move constructor
+  /*! \param other  other instance
+   */
+  scale_nanoseconds(scale_type&& other) noexcept : _frequency(other._frequency), _start(other._start), _position(other._position) { }
+
+  //! Shifted copy constructor
+  /*! \param n      shift scale by \a n periods
+   *  \param other  other instance
+   */
+  scale_nanoseconds(ssize_t n, const scale_type& other) : _frequency(other._frequency), _start(other._start), _position(other._position + n) { }
+
+  scale_nanoseconds(boost::gregorian::special_values, const scale_type& other) : _frequency(other._frequency), _start(other._start) {
+    throw std::logic_error("the time to point to cannot be a special value");
+  }
+
+  //! Shifted copy constructor
+  /*! \param ts     shift scale to this ptime
+   *  \param other  other instance
+   */
+  scale_nanoseconds(const ptime& ts, const scale_type& other) : _frequency(other._frequency), _start(other._start) {
+    if(ts.is_special())
+      throw std::logic_error("the time to point to cannot be a special value");
+    _position = (detail::epoch_nanoseconds(ts) - _start) / (_frequency * Multiplier);  // integer division
+  }
+
+  //! Shifted copy constructor
+  /*! \param ts     shift scale to this local_date_time -- note that the time zone info is lost
+   *  \param other  other instance
+   */
+  scale_nanoseconds(const local_date_time& ldt, const scale_type& other) : scale_nanoseconds(ldt.utc_time(), other) { }
+
+
+  //                   //
+  // special instances //
+  //                   //
+
+  scale_type reference() const { return scale_type(_start, _start, _frequency); }
+
+  //! the scale shifted to \a ns nanoseconds since 1970-01-01
+  scale_type at(int64_t ns) const { return scale_type(ns, _start, _frequency); }
+
+
+  //            //
+  // assignment //
+  //            //
+
+  //! assignment
+  scale_type& operator= (const scale_type& rhs) {
+    _position = rhs._position;
+    _frequency = rhs._frequency;
+    _start = rhs._start;
+    return *this;
+  }
+
+  //! move assignment
+  scale_type& operator= (scale_type&& rhs) noexcept {
+    _position = rhs._position;
+    _frequency = rhs._frequency;
+    _start = rhs._start;
+    return *this;
+  }
+
+
+  //                      //
+  // arithmetic operators //
+  //                      //
+
+  //! prefix ++ operator
+  scale_type& operator++ () {
+    ++_position;
+    return *this;
+  }
+
+  //! postfix ++ operator
+  scale_type operator++ (int) {
+    scale_type tmp(*this);
+    ++(*this);
+    return tmp;
+  }
+
+  //! prefix -- operator
+  scale_type& operator-- () {
+    --_position;
+    return *this;
+  }
+
+  //! postfix -- operator
+  scale_type operator-- (int) {
+    scale_type tmp(*this);
+    --(*this);
+    return tmp;
+  }
+
+  //! in-place + operator
+  scale_type& operator+= (unsigned long i) {
+    _position += i;
+    return *this;
+  }
+
+  //! + operator
+  scale_type operator+ (unsigned long i) const {
+    scale_type tmp(*this);
+    return (tmp += i);
+  }
+
+  //! in-place - operator
+  scale_type& operator-= (unsigned long i) {
+    _position -= i;
+    return *this;
+  }
+
+  //! - operator
+  scale_type operator- (unsigned long i) const {
+    scale_type tmp(*this);
+    return (tmp -= i);
+  }
+
+
+  //                      //
+  // comparison operators //
+  //                      //
+
+  //! equality operator
+  bool operator== (const scale_type& rhs) const {
+    return _position == rhs._position && _frequency == rhs._frequency && _start == rhs._start;
+  }
+
+  //! inequality operator
+  bool operator!= (const scale_type& rhs) const {
+    return !(*this == rhs);
+  }
+
+
+  //                //
+  // length related //
+  //                //
+
+  //! instances difference
+  long operator- (const scale_type& rhs) const {
+    return _position - value_at(rhs.nanoseconds());
+  }
+
+  // LCOV_EXCL_START
+  //! numerical value
+  long value() const { return _position; }
+  // LCOV_EXCL_STOP
+
+  //! value of the scale at \a ns nanoseconds since 1970-01-01
+  long value_at(int64_t ns) const { return (ns - _start) / (_frequency * Multiplier); }
+
+
+  //              //
+  // current time //
+  //              //
+
+  //! start of the current period, in nanoseconds since 1970-01-01
+  int64_t nanoseconds() const { return _start + Multiplier * _frequency * _position; }
+
+  //! end of the current period, excluded, in nanoseconds since 1970-01-01
+  int64_t end_nanoseconds() const { return nanoseconds() + Multiplier * _frequency; }
+
+  local_date_time local_time() const override {
+    return local_date_time(utc_time(), time_zone_const_ptr());
+  }
+
+  ptime utc_time() const override {
+    return detail::from_epoch_nanoseconds(nanoseconds());
+  }
+
+  //! writes the starts of the \a n periods starting at the current one to \a out, in nanoseconds since 1970-01-01
+  void nanoseconds_into(int64_t* out, size_t n) const {
+    detail::fill_grid(nanoseconds(), Multiplier * _frequency, out, n);
+  }
+
+  //! writes the values of the scale at the \a n times \a ns, in nanoseconds since 1970-01-01, to \a out
+  void nanosecond_positions_into(const int64_t* ns, int64_t* out, size_t n) const {
+    detail::bucket_grid(ns, _start, Multiplier * _frequency, out, n);
+  }
+
+  //! writes the utc times of the \a n values starting at the current one to \a out
+  void utc_time_into(ptime* out, size_t n) const {
+    const int64_t step = Multiplier * _frequency;
+    int64_t t = nanoseconds();
+    for(size_t i=0; i<n; ++i, t+=step)
+      out[i] = detail::from_epoch_nanoseconds(t);
+  }
+
+  //! writes the utc times of the \a n values starting at the current one to \a out, in microseconds since 1970-01-01
+  void utc_microseconds_into(int64_t* out, size_t n) const {
+    const int64_t step = Multiplier * _frequency;
+    int64_t t = nanoseconds();
+    for(size_t i=0; i<n; ++i, t+=step)
+      out[i] = (t >= 0 ? t : t - 999) / 1000;
+  }
+
+  //! writes the values of the scale at the \a n utc times \a utc_us, in microseconds since 1970-01-01, to \a out
+  void positions_into(const int64_t* utc_us, int64_t* out, size_t n) const {
+    const int64_t step = Multiplier * _frequency;
+    for(size_t i=0; i<n; ++i)
+      out[i] = (detail::nanoseconds_from_microseconds(utc_us[i]) - _start) / step;
+  }
+
+
+  //                       //
+  // string representation //
+  //                       //
+
+  //! writes the label of the current period to \a out, max_label_size chars long, returns its length
+  size_t label(char* out) const {
+    typename Labeler::cursor_type cursor;
+    return write_label(cursor, out, label_time(), end_nanoseconds());
+  }
+
+  //! time given to the labeler for the current period, in nanoseconds since 1970-01-01
+  int64_t label_time() const { return nanoseconds(); }
+
+  //! writes the label of the period from \a t to \a next to \a out, returns its length
+  static size_t write_label(typename Labeler::cursor_type& cursor, char* out, int64_t t, int64_t next) {
+    return detail::nanoseconds_label<Labeler>::write(cursor, out, t, next);
+  }
+
+  //! string representation
+  std::string to_string() const {
+    char buffer[max_label_size];
+    return std::string(buffer, label(buffer));
+  }
+
+  //! ostream operator <<
+  friend std::ostream& operator << (std::ostream& out, const scale_type& scale) {
+    out << scale.to_string();
+    return out;
+  }
+
+private:
+  long     _frequency;
+  int64_t  _start;     // nanoseconds since 1970-01-01
+  long     _position;
+
+  //! \a start in nanoseconds since 1970-01-01
+  static int64_t anchor(const ptime& start) {
+    if(start.is_special())
+      throw std::logic_error("the start time cannot be a special value");
+    return detail::epoch_nanoseconds(start);
+  }
+};
+
+
+}
+
+#endif // TIMESCALES_SCALE_NANOSECONDS_HPP
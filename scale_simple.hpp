@@ -3,21 +3,107 @@
 
 #include "timescale.hpp"
 
+#if defined(__AVX2__) || defined(__AVX512F__)
+#include <immintrin.h>
+#endif
+
 namespace timescales {
 
 namespace detail {
-  
-inline std::pair<boost::gregorian::date_duration, boost::posix_time::time_duration> duration_from_microseconds(int64_t t) {
-  long long dt = t / 86400000000LL;
-  long long tm = t % 86400000000LL;
-  long h = tm / 3600000000;
-  long m = (tm % 3600000000) / 60000000;
-  long s = (tm % 60000000) / 1000000;
-  long msecs = tm % 1000000;
-  
-  return std::make_pair(boost::gregorian::days(dt), boost::posix_time::time_duration(h, m, s, msecs));
+
+
+//                   //
+// bulk grid kernels //
+//                   //
+
+//! bound on the distances to the origin handled by the vector bucketing kernels, which go through doubles
+static const int64_t grid_vector_bound = 1LL << 51;
+
+//! writes the \a n boundaries \a t0, \a t0 + \a step, ... to \a out
+inline void fill_grid(int64_t t0, int64_t step, int64_t* out, size_t n) {
+  size_t i = 0;
+#if defined(__AVX512F__)
+  const __m512i inc8 = _mm512_set1_epi64(8 * step);
+  __m512i v8 = _mm512_set_epi64(t0 + 7*step, t0 + 6*step, t0 + 5*step, t0 + 4*step,
+                                t0 + 3*step, t0 + 2*step, t0 + step, t0);
+  for(; i+8<=n; i+=8) {
+    _mm512_storeu_si512(reinterpret_cast<void*>(out + i), v8);
+    v8 = _mm512_add_epi64(v8, inc8);
+  }
+#elif defined(__AVX2__)
+  const __m256i inc4 = _mm256_set1_epi64x(4 * step);
+  __m256i v4 = _mm256_set_epi64x(t0 + 3*step, t0 + 2*step, t0 + step, t0);
+  for(; i+4<=n; i+=4) {
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), v4);
+    v4 = _mm256_add_epi64(v4, inc4);
+  }
+#endif
+  for(int64_t t=t0+static_cast<int64_t>(i)*step; i<n; ++i, t+=step)
+    out[i] = t;
 }
- 
+
+//! writes the indices (\a t[i] - \a origin) / \a period of the \a n times \a t to \a out
+/*! The division truncates toward zero, as in the scale_simple constructor. The vector kernels estimate
+ *  the quotient in double precision and correct it by one with the exact remainder; blocks holding a
+ *  distance beyond grid_vector_bound go through the scalar loop.
+ */
+inline void bucket_grid(const int64_t* t, int64_t origin, int64_t period, int64_t* out, size_t n) {
+  size_t i = 0;
+#if defined(__AVX512F__) && defined(__AVX512DQ__)
+  if(period < grid_vector_bound) {
+    const __m512i o8 = _mm512_set1_epi64(origin), p8 = _mm512_set1_epi64(period), mp8 = _mm512_set1_epi64(-period);
+    const __m512i hi8 = _mm512_set1_epi64(grid_vector_bound), lo8 = _mm512_set1_epi64(-grid_vector_bound);
+    const __m512i zero8 = _mm512_setzero_si512(), one8 = _mm512_set1_epi64(1);
+    const __m512d pd8 = _mm512_set1_pd(static_cast<double>(period));
+    for(; i+8<=n; i+=8) {
+      __m512i d = _mm512_sub_epi64(_mm512_loadu_si512(reinterpret_cast<const void*>(t + i)), o8);
+      if(_mm512_cmpgt_epi64_mask(d, hi8) | _mm512_cmplt_epi64_mask(d, lo8)) {
+        for(size_t j=i; j<i+8; ++j)
+          out[j] = (t[j] - origin) / period;
+        continue;
+      }
+      __m512i q = _mm512_cvttpd_epi64(_mm512_div_pd(_mm512_cvtepi64_pd(d), pd8));
+      __m512i r = _mm512_sub_epi64(d, _mm512_mullo_epi64(q, p8));
+      __mmask8 dec = (_mm512_cmplt_epi64_mask(r, zero8) & _mm512_cmpge_epi64_mask(d, zero8)) | _mm512_cmple_epi64_mask(r, mp8);
+      __mmask8 inc = (_mm512_cmpgt_epi64_mask(r, zero8) & _mm512_cmplt_epi64_mask(d, zero8)) | _mm512_cmpge_epi64_mask(r, p8);
+      q = _mm512_mask_sub_epi64(q, dec, q, one8);
+      q = _mm512_mask_add_epi64(q, inc, q, one8);
+      _mm512_storeu_si512(reinterpret_cast<void*>(out + i), q);
+    }
+  }
+#elif defined(__AVX2__)
+  if(period < grid_vector_bound) {
+    // integers below 2^51 in magnitude convert to and from doubles by adding 2^52 + 2^51 to the mantissa
+    const __m256d magic = _mm256_set1_pd(6755399441055744.0);
+    const __m256i magic_i = _mm256_castpd_si256(magic);
+    const __m256i o4 = _mm256_set1_epi64x(origin);
+    const __m256i hi4 = _mm256_set1_epi64x(grid_vector_bound), lo4 = _mm256_set1_epi64x(-grid_vector_bound);
+    const __m256d p4 = _mm256_set1_pd(static_cast<double>(period)), mp4 = _mm256_set1_pd(-static_cast<double>(period));
+    const __m256d zero4 = _mm256_setzero_pd(), one4 = _mm256_set1_pd(1.0);
+    for(; i+4<=n; i+=4) {
+      __m256i d = _mm256_sub_epi64(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(t + i)), o4);
+      __m256i out_of_range = _mm256_or_si256(_mm256_cmpgt_epi64(d, hi4), _mm256_cmpgt_epi64(lo4, d));
+      if(!_mm256_testz_si256(out_of_range, out_of_range)) {
+        for(size_t j=i; j<i+4; ++j)
+          out[j] = (t[j] - origin) / period;
+        continue;
+      }
+      __m256d dd = _mm256_sub_pd(_mm256_castsi256_pd(_mm256_add_epi64(d, magic_i)), magic);
+      __m256d q = _mm256_round_pd(_mm256_div_pd(dd, p4), _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC);
+      __m256d r = _mm256_sub_pd(dd, _mm256_mul_pd(q, p4));  // exact, every term is an integer below 2^53
+      __m256d dec = _mm256_or_pd(_mm256_and_pd(_mm256_cmp_pd(r, zero4, _CMP_LT_OQ), _mm256_cmp_pd(dd, zero4, _CMP_GE_OQ)),
+                                 _mm256_cmp_pd(r, mp4, _CMP_LE_OQ));
+      __m256d inc = _mm256_or_pd(_mm256_and_pd(_mm256_cmp_pd(r, zero4, _CMP_GT_OQ), _mm256_cmp_pd(dd, zero4, _CMP_LT_OQ)),
+                                 _mm256_cmp_pd(r, p4, _CMP_GE_OQ));
+      q = _mm256_add_pd(_mm256_sub_pd(q, _mm256_and_pd(dec, one4)), _mm256_and_pd(inc, one4));
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), _mm256_sub_epi64(_mm256_castpd_si256(_mm256_add_pd(q, magic)), magic_i));
+    }
+  }
+#endif
+  for(; i<n; ++i)
+    out[i] = (t[i] - origin) / period;
+}
+
 }
   
   
@@ -49,9 +135,7 @@ public:
   /*! \param start  anchor
    *  \param freq   frequency
    */
-  scale_simple(const ptime& start, long freq) : _frequency(freq), _start(start), _position(0) {
-    if(start.is_special())
-      throw std::logic_error("the start time cannot be a special value");
+  scale_simple(const ptime& start, long freq) : _frequency(freq), _start(anchor(start)), _position(0) {
     if(_frequency <= 0)
       throw std::logic_error("frequency must be positive");
   }
@@ -61,20 +145,24 @@ public:
    *  \param start  anchor
    *  \param freq   frequency
    */
-  explicit scale_simple(const ptime& ts, const ptime& start=boost::posix_time::special_values::not_a_date_time, long freq=1) : _frequency(freq), _start(start) { 
+  explicit scale_simple(const ptime& ts, const ptime& start=boost::posix_time::special_values::not_a_date_time, long freq=1) : _frequency(freq) { 
     if(ts.is_special())
       throw std::logic_error("the time to point to cannot be a special value");
-    if(_start.is_special())
-      _start = ts;
+    _start = detail::epoch_microseconds(start.is_special() ? ts : start);
     if(_frequency <= 0)
       throw std::logic_error("frequency must be positive");
-    _position = (ts - _start).total_microseconds() / (_frequency * Multiplier);  // integer division
+    _position = (detail::epoch_microseconds(ts) - _start) / (_frequency * Multiplier);  // integer division
   }
 
   //! Copy constructor
   /*! \param other  other instance
    */
   scale_simple(const scale_type& other) : _frequency(other._frequency), _start(other._start), _position(other._position) { }
+
+  //! Move constructor
+  /*! \param other  other instance
+   */
+  scale_simple(scale_type&& other) noexcept : _frequency(other._frequency), _start(other._start), _position(other._position) { }
   
   //! Shifted copy constructor
   /*! \param n      shift scale by \a n periods
@@ -86,20 +174,24 @@ public:
   /*! \param ts     shift scale to this ptime
    *  \param other  other instance
    */
-  scale_simple(const ptime& ts, const scale_type& other) : scale_simple(ts, other._start, other._frequency) { }
+  scale_simple(const ptime& ts, const scale_type& other) : _frequency(other._frequency), _start(other._start) {
+    if(ts.is_special())
+      throw std::logic_error("the time to point to cannot be a special value");
+    _position = (detail::epoch_microseconds(ts) - _start) / (_frequency * Multiplier);  // integer division
+  }
   
   //! Shifted copy constructor
   /*! \param ts     shift scale to this local_date_time -- note that the time zone info is lost
    *  \param other  other instance
    */
-  scale_simple(const local_date_time& ldt, const scale_type& other) : scale_simple(ldt.utc_time(), other._start, other._frequency) { }
+  scale_simple(const local_date_time& ldt, const scale_type& other) : scale_simple(ldt.utc_time(), other) { }
   
   
   //                   //
   // special instances //
   //                   //  
 
-  scale_type reference() const { return scale_type(_start, *this); }
+  scale_type reference() const { return scale_type(detail::from_epoch_microseconds(_start), *this); }
   
   
   //            //
@@ -114,6 +206,14 @@ public:
     return *this;
   }
 
+  //! move assignment
+  scale_type& operator= (scale_type&& rhs) noexcept { 
+    _position = rhs._position;
+    _frequency = rhs._frequency;
+    _start = rhs._start;
+    return *this;
+  }
+
   
   //                      //
   // arithmetic operators //
@@ -191,7 +291,7 @@ public:
 
   //! instances difference
   long operator- (const scale_type& rhs) const { 
-    return _position - scale_type(rhs.utc_time(), _start, _frequency)._position; 
+    return _position - scale_type(rhs.utc_time(), *this)._position; 
   }
   
   // LCOV_EXCL_START
@@ -209,8 +309,27 @@ public:
   }
   
   ptime utc_time() const override { 
-    auto d = detail::duration_from_microseconds(Multiplier * _frequency * _position);
-    return _start + d.first + d.second;
+    return detail::from_epoch_microseconds(_start + Multiplier * _frequency * _position);
+  }
+
+  //! writes the utc times of the \a n values starting at the current one to \a out
+  void utc_time_into(ptime* out, size_t n) const {
+    const int64_t step = Multiplier * _frequency;
+    const ptime start = detail::from_epoch_microseconds(_start);
+    int64_t t = step * _position;
+    for(size_t i=0; i<n; ++i, t+=step)
+      out[i] = start + boost::posix_time::microseconds(t);
+  }
+
+  //! writes the utc times of the \a n values starting at the current one to \a out, in microseconds since 1970-01-01
+  void utc_microseconds_into(int64_t* out, size_t n) const {
+    const int64_t step = Multiplier * _frequency;
+    detail::fill_grid(_start + step * _position, step, out, n);
+  }
+
+  //! writes the values of the scale at the \a n utc times \a utc_us, in microseconds since 1970-01-01, to \a out
+  void positions_into(const int64_t* utc_us, int64_t* out, size_t n) const {
+    detail::bucket_grid(utc_us, _start, Multiplier * _frequency, out, n);
   }
   
   
@@ -218,8 +337,25 @@ public:
   // string representation //
   //                       //
   
+  //! writes the label of the current period to \a out, max_label_size chars long, returns its length
+  size_t label(char* out) const {
+    typename Labeler::cursor_type cursor;
+    return write_label(cursor, out, label_time(), (*this+1).label_time());
+  }
+
+  //! time given to the labeler for the current period
+  ptime label_time() const { return utc_time(); }
+
+  //! writes the label of the period from \a t to \a next to \a out, returns its length
+  static size_t write_label(typename Labeler::cursor_type& cursor, char* out, const ptime& t, const ptime& next) {
+    return Labeler::write_with(cursor, out, t, next-boost::posix_time::time_duration(0,0,0,1));
+  }
+
   //! string representation
-  std::string to_string() const { return Labeler::str(utc_time(), (*this+1).utc_time()-boost::posix_time::time_duration(0,0,0,1)); }
+  std::string to_string() const {
+    char buffer[max_label_size];
+    return std::string(buffer, label(buffer));
+  }
 
   //! ostream operator <<
   friend std::ostream& operator << (std::ostream& out, const scale_type& scale) { 
@@ -228,9 +364,16 @@ public:
   }
     
 private:
-  long   _frequency;
-  ptime  _start;
-  long   _position;
+  long     _frequency;
+  int64_t  _start;     // microseconds since 1970-01-01
+  long     _position;
+
+  //! \a start in microseconds since 1970-01-01
+  static int64_t anchor(const ptime& start) {
+    if(start.is_special())
+      throw std::logic_error("the start time cannot be a special value");
+    return detail::epoch_microseconds(start);
+  }
 };
 
 
@@ -5,6 +5,157 @@
 
 namespace timescales {
 
+namespace detail {
+
+//! Rank/select index over the periods of a base scale that fall on holidays.
+/*! Bit \a i is set when the period with value lo()+i of the base scale is a holiday, values being 
+ *  relative to the reference of the base scale. Per block of 64 periods the number of holidays before 
+ *  it is kept, so that counting and locating non-holiday periods does not walk the base scale.
+ *  Indexes are immutable: growing the covered range builds a new one, so they can be shared between 
+ *  copies of a scale on different threads. Scales built separately over the same holidays and base 
+ *  reference find the index of each other in the index cache of the holidays, as long as one of them 
+ *  holds it.
+ */
+template<class BaseScale>
+class holidays_index {
+public:
+  typedef std::shared_ptr<const holidays_index>   const_ptr;
+
+  //! first covered value
+  long lo() const { return _lo; }
+
+  //! one past the last covered value
+  long hi() const { return _hi; }
+
+  //! true if \a v is in [lo(), hi())
+  bool covers(long v) const { return v >= _lo && v < _hi; }
+
+  //! true if the period with value \a v is a holiday, \a v must be covered
+  bool is_holiday(long v) const {
+    long i = v - _lo;
+    return (_bits[i >> 6] >> (i & 63)) & 1;
+  }
+
+  //! number of non-holiday periods in [lo(), v), \a v in [lo(), hi()]
+  long rank(long v) const {
+    long i = v - _lo;
+    long w = i >> 6;
+    long hol = _holidays_before[w];
+    if(i & 63)
+      hol += popcount(_bits[w] & ((uint64_t(1) << (i & 63)) - 1));
+    return i - hol;
+  }
+
+  //! number of non-holiday periods covered
+  long non_holidays() const { return rank(_hi); }
+
+  //! value of the non-holiday period with rank \a k, \a k in [0, non_holidays())
+  long select(long k) const {
+    // last block with less than k+1 non-holidays before it
+    size_t first = 0, last = _bits.size();
+    while(last - first > 1) {
+      size_t mid = first + (last - first) / 2;
+      if(non_holidays_before(mid) <= k)
+        first = mid;
+      else
+        last = mid;
+    }
+    uint64_t free_days = ~_bits[first];
+    for(long j=k-non_holidays_before(first); j>0; --j)
+      free_days &= free_days - 1;
+    return _lo + 64 * static_cast<long>(first) + lowest_bit(free_days);
+  }
+
+  //! index covering at least [a, b], reusing \a idx when possible
+  static const_ptr grow(const const_ptr& idx, const BaseScale& base, const holidays_const_ptr& hol, long a, long b) {
+    if(idx && idx->covers(a) && idx->covers(b))
+      return idx;
+    
+    // double the covered range on the side(s) that need it
+    long margin = idx ? std::max(idx->_hi - idx->_lo, 512L) : 512L;
+    long lo = idx ? std::min(a, idx->_lo) : a;
+    long hi = idx ? std::max(b + 1, idx->_hi) : b + 1;
+    if(!idx || a < idx->_lo)
+      lo -= margin;
+    if(!idx || b >= idx->_hi)
+      hi += margin;
+    lo = floor64(lo);
+    hi = floor64(hi + 63);
+
+    std::shared_ptr<holidays_index> result(new holidays_index(lo, hi));
+    if(idx) {
+      std::copy(idx->_bits.begin(), idx->_bits.end(), result->_bits.begin() + (idx->_lo - lo) / 64);
+      result->fill(base, hol, lo, idx->_lo);
+      result->fill(base, hol, idx->_hi, hi);
+    }
+    else
+      result->fill(base, hol, lo, hi);
+    
+    for(size_t w=0; w<result->_bits.size(); ++w)
+      result->_holidays_before[w+1] = result->_holidays_before[w] + popcount(result->_bits[w]);
+    return result;
+  }
+
+  //! Base reference an index is built for, and its zone, which the equality of scales leaves out.
+  struct key_type {
+    BaseScale            reference;
+    time_zone_const_ptr  zone;
+
+    bool operator== (const key_type& rhs) const { return zone == rhs.zone && reference == rhs.reference; }
+  };
+
+  //! key of the indexes over the base scale \a base
+  static key_type key_of(const BaseScale& base) {
+    BaseScale reference(base.reference());
+    const time_zone_const_ptr zone(reference.local_time().zone());
+    return key_type { std::move(reference), zone };
+  }
+
+private:
+  long                  _lo;
+  long                  _hi;
+  std::vector<uint64_t> _bits;
+  std::vector<long>     _holidays_before;
+
+  holidays_index(long lo, long hi) : _lo(lo), _hi(hi), _bits((hi - lo) / 64, 0), _holidays_before((hi - lo) / 64 + 1, 0) { }
+
+  static long floor64(long v) {
+    return v >= 0 ? v & ~63L : -((-v + 63) & ~63L);
+  }
+
+  long non_holidays_before(size_t w) const {
+    return 64 * static_cast<long>(w) - _holidays_before[w];
+  }
+
+  //! marks the holidays in [from, to)
+  void fill(const BaseScale& base, const holidays_const_ptr& hol, long from, long to) {
+    if(from >= to)
+      return;
+    BaseScale scale = base.reference();
+    if(from > 0)
+      scale += static_cast<unsigned long>(from);
+    else if(from < 0)
+      scale -= static_cast<unsigned long>(-from);
+    
+    // fetch the holidays between the first and last dates in one call
+    BaseScale last_scale = scale + static_cast<unsigned long>(to - 1 - from);
+    const boost::gregorian::date first = helper<BaseScale>::date(&scale);
+    const boost::gregorian::date last = helper<BaseScale>::date(&last_scale) + boost::gregorian::days(1);
+    std::vector<uint64_t> days((days_in_range(first, last) + 63) / 64, 0);
+    hol->fill_holidays(first, last, days.data());
+    
+    for(long v=from; v<to; ++v, ++scale) {
+      long i = v - _lo;
+      long d = (helper<BaseScale>::date(&scale) - first).days();
+      if((days[d >> 6] >> (d & 63)) & 1)
+        _bits[i >> 6] |= uint64_t(1) << (i & 63);
+    }
+  }
+};
+
+}
+
+
 template<class BaseScale, class Labeler=typename BaseScale::labeler_type>
 class scale_with_holidays : public detail::timescale<scale_with_holidays<BaseScale, Labeler> > {
   
@@ -22,65 +173,60 @@ public:
   //              //
   // constructors //
   //              //  
-  explicit scale_with_holidays(const ptime& start, long frequency=1, time_zone_const_ptr tz=nullptr, holidays_const_ptr hol=nullptr) : _frequency(frequency), _holidays(hol), _position(0) { 
+  explicit scale_with_holidays(const ptime& start, long frequency=1, time_zone_const_ptr tz=nullptr, holidays_const_ptr hol=nullptr) 
+    : _frequency(frequency), _base(detail::helper<BaseScale>::create(start, tz)), _holidays(hol), _position(0) { 
     if(start.is_special())
       throw std::logic_error("the start time cannot be a special value");
     if(_frequency <= 0)
       throw std::logic_error("frequency must be positive");
-    _base.reset(detail::helper<BaseScale>::create(start, tz));
     back_to_non_holiday();
   }
 
-  explicit scale_with_holidays(const local_date_time& start, long frequency=1, holidays_const_ptr hol=nullptr) : _frequency(frequency), _holidays(hol), _position(0) { 
+  explicit scale_with_holidays(const local_date_time& start, long frequency=1, holidays_const_ptr hol=nullptr) 
+    : _frequency(frequency), _base(detail::helper<BaseScale>::create(start)), _holidays(hol), _position(0) { 
     if(start.is_special())
       throw std::logic_error("the start time cannot be a special value");
     if(_frequency <= 0)
       throw std::logic_error("frequency must be positive");
-    _base.reset(detail::helper<BaseScale>::create(start));
     back_to_non_holiday();
   }
 
-  scale_with_holidays(const ptime& tm, const ptime& start, long frequency=1, time_zone_const_ptr tz=nullptr, holidays_const_ptr hol=nullptr) : _frequency(frequency), _holidays(hol) { 
+  scale_with_holidays(const ptime& tm, const ptime& start, long frequency=1, time_zone_const_ptr tz=nullptr, holidays_const_ptr hol=nullptr) 
+    : _frequency(frequency), _base(detail::helper<BaseScale>::create(tm, start.is_special() ? tm : start, tz)), _holidays(hol) { 
     if(tm.is_special())
       throw std::logic_error("the time to point to cannot be a special value");
     if(_frequency <= 0)
       throw std::logic_error("frequency must be positive");
-    if(start.is_special())
-      _base.reset(detail::helper<BaseScale>::create(tm, tm, tz));
-    else
-      _base.reset(detail::helper<BaseScale>::create(tm, start, tz));
     back_to_non_holiday();
     update_position();
   }
   
-  scale_with_holidays(const ptime& tm, const local_date_time& start, long frequency=1, holidays_const_ptr hol=nullptr) : _frequency(frequency), _holidays(hol) { 
+  scale_with_holidays(const ptime& tm, const local_date_time& start, long frequency=1, holidays_const_ptr hol=nullptr) 
+    : _frequency(frequency), _base(start.is_special() ? detail::helper<BaseScale>::create(tm, tm, start.zone()) : detail::helper<BaseScale>::create(tm, start)), _holidays(hol) { 
     if(tm.is_special())
       throw std::logic_error("the time to point to cannot be a special value");
     if(_frequency <= 0)
       throw std::logic_error("frequency must be positive");
-    if(start.is_special())
-      _base.reset(detail::helper<BaseScale>::create(tm, tm, start.zone()));
-    else
-      _base.reset(detail::helper<BaseScale>::create(tm, start));
     back_to_non_holiday();
     update_position();
   }
 
-  scale_with_holidays(const local_date_time& tm, const local_date_time& start, long frequency=1, holidays_const_ptr hol=nullptr) : _frequency(frequency), _holidays(hol) { 
+  scale_with_holidays(const local_date_time& tm, const local_date_time& start, long frequency=1, holidays_const_ptr hol=nullptr) 
+    : _frequency(frequency), _base(detail::helper<BaseScale>::create(tm, start.is_special() ? tm : start)), _holidays(hol) { 
     if(tm.is_special())
       throw std::logic_error("the time to point to cannot be a special value");
     if(_frequency <= 0)
       throw std::logic_error("frequency must be positive");
-    if(start.is_special())
-      _base.reset(detail::helper<BaseScale>::create(tm, tm));
-    else
-      _base.reset(detail::helper<BaseScale>::create(tm, start));
     back_to_non_holiday();
     update_position();
   }
   
   //! copy constructor
-  scale_with_holidays(const scale_type& rhs) : _frequency(rhs._frequency), _base(new BaseScale(*rhs._base)), _holidays(rhs._holidays), _position(rhs._position) { }
+  scale_with_holidays(const scale_type& rhs) : _frequency(rhs._frequency), _base(rhs._base), _holidays(rhs._holidays), _index(rhs._index), _position(rhs._position) { }
+  
+  //! move constructor
+  scale_with_holidays(scale_type&& rhs) noexcept 
+    : _frequency(rhs._frequency), _base(std::move(rhs._base)), _holidays(std::move(rhs._holidays)), _index(std::move(rhs._index)), _position(rhs._position) { }
   
   
   //! Shifted copy constructor
@@ -89,18 +235,18 @@ public:
    */
   scale_with_holidays(ssize_t n, const scale_type& rhs) : scale_with_holidays((rhs + n).local_time(), rhs) { }
   
-  scale_with_holidays(boost::gregorian::special_values, const scale_type& rhs) { 
+  scale_with_holidays(boost::gregorian::special_values, const scale_type& rhs) : _base(rhs._base) { 
     throw std::logic_error("the start time cannot be a special value");
   }
   
   //! shifted copy constructor
-  scale_with_holidays(const ptime& tm, const scale_type& rhs) : _frequency(rhs._frequency), _base(new BaseScale(tm, *rhs._base)), _holidays(rhs._holidays) {
+  scale_with_holidays(const ptime& tm, const scale_type& rhs) : _frequency(rhs._frequency), _base(tm, rhs._base), _holidays(rhs._holidays), _index(rhs._index) {
     back_to_non_holiday();
     update_position();
   }
   
   //! shifted copy constructor
-  scale_with_holidays(const local_date_time& tm, const scale_type& rhs) : _frequency(rhs._frequency), _base(new BaseScale(tm, *rhs._base)), _holidays(rhs._holidays) {
+  scale_with_holidays(const local_date_time& tm, const scale_type& rhs) : _frequency(rhs._frequency), _base(tm, rhs._base), _holidays(rhs._holidays), _index(rhs._index) {
     back_to_non_holiday();
     update_position();
   }
@@ -111,7 +257,7 @@ public:
   //                   //  
 
   scale_type reference() const { 
-    return scale_type(_base->reference().utc_time(), *this);
+    return scale_type(_base.reference().utc_time(), *this);
   }
   
   
@@ -122,9 +268,20 @@ public:
   //! assignment
   scale_type& operator= (const scale_type& rhs) { 
     _position = rhs._position;
-    _base.reset(new BaseScale(*rhs._base));
+    _base = rhs._base;
     _frequency = rhs._frequency;
     _holidays = rhs._holidays;
+    _index = rhs._index;
+    return *this;
+  }
+
+  //! move assignment
+  scale_type& operator= (scale_type&& rhs) noexcept { 
+    _position = rhs._position;
+    _base = std::move(rhs._base);
+    _frequency = rhs._frequency;
+    _holidays = std::move(rhs._holidays);
+    _index = std::move(rhs._index);
     return *this;
   }
 
@@ -136,7 +293,7 @@ public:
   //! prefix ++ operator
   scale_type& operator++ () { 
     ++_position;
-    ++(*_base);
+    ++_base;
     advance_to_non_holiday();
     return *this; 
   }
@@ -151,7 +308,7 @@ public:
   //! prefix -- operator
   scale_type& operator-- () { 
     --_position; 
-    --(*_base);
+    --_base;
     back_to_non_holiday();
     return *this; 
   }
@@ -165,8 +322,17 @@ public:
   
   //! in-place + operator
   scale_type& operator+= (unsigned long i) { 
-    for(unsigned long j=0; j<i; ++j)
-      ++(*this);
+    if(!_holidays) {
+      _base += i;
+      _position += i;
+      return *this;
+    }
+    long v = _base.value();
+    ensure_index(v, v);
+    while(_index->rank(v) + static_cast<long>(i) >= _index->non_holidays())
+      ensure_index(v, _index->hi());
+    move_base_to(_index->select(_index->rank(v) + static_cast<long>(i)));
+    _position += i;
     return *this;
   }
   
@@ -178,8 +344,17 @@ public:
   
   //! in-place - operator
   scale_type& operator-= (unsigned long i) { 
-    for(unsigned long j=0; j<i; ++j)
-      --(*this);
+    if(!_holidays) {
+      _base -= i;
+      _position -= i;
+      return *this;
+    }
+    long v = _base.value();
+    ensure_index(v, v);
+    while(_index->rank(v) < static_cast<long>(i))
+      ensure_index(_index->lo() - 1, v);
+    move_base_to(_index->select(_index->rank(v) - static_cast<long>(i)));
+    _position -= i;
     return *this;
   }
   
@@ -196,7 +371,7 @@ public:
   
   //! equality operator
   bool operator== (const scale_type& rhs) const {
-    return _frequency == rhs._frequency && _holidays.get() == rhs._holidays.get() && *_base == *rhs._base;
+    return _frequency == rhs._frequency && _holidays.get() == rhs._holidays.get() && _base == rhs._base;
   }
   
   //! inequality operator
@@ -225,11 +400,11 @@ public:
   //              //
   
   local_date_time local_time() const override {
-    return _base->local_time();
+    return _base.local_time();
   }
   
   ptime utc_time() const override { 
-    return _base->utc_time();
+    return _base.utc_time();
   }
   
   
@@ -237,12 +412,27 @@ public:
   // string representation //
   //                       //
   
+  //! writes the label of the current period to \a out, max_label_size chars long, returns its length
+  size_t label(char* out) const {
+    typename Labeler::cursor_type cursor;
+    return write_label(cursor, out, label_time(), (*this+1).label_time());
+  }
+
+  //! time given to the labeler for the current period
+  auto label_time() const -> decltype(detail::helper<BaseScale>::time(nullptr)) {
+    return detail::helper<BaseScale>::time(&_base);
+  }
+
+  //! writes the label of the period from \a t to \a next to \a out, returns its length
+  template<class T>
+  static size_t write_label(typename Labeler::cursor_type& cursor, char* out, const T& t, const T& next) {
+    return Labeler::write_with(cursor, out, t, next-boost::posix_time::time_duration(0,0,0,1));
+  }
+
   //! string representation
   std::string to_string() const {
-    auto t0 = detail::helper<BaseScale>::time(_base.get());
-    auto scale_end = (*this+1);
-    auto t1 = detail::helper<BaseScale>::time(scale_end._base.get())-boost::posix_time::time_duration(0,0,0,1);
-    return Labeler::str(t0, t1); 
+    char buffer[max_label_size];
+    return std::string(buffer, label(buffer));
   }
 
   //! ostream operator <<
@@ -253,49 +443,68 @@ public:
   
   
 private:
-  long                          _frequency;
-  std::unique_ptr<BaseScale>    _base;
+  typedef detail::holidays_index<BaseScale>   index_type;
+
+  long                                _frequency;
+  BaseScale                           _base;
   holidays_const_ptr                  _holidays;
-  long                          _position;
+  typename index_type::const_ptr      _index;
+  long                                _position;
+  
+  //! makes sure the holidays index covers the base values [a, b], sharing it with the scales built alike
+  void ensure_index(long a, long b) {
+    if(!_index)
+      _index = _holidays->index_cache().find<index_type>(index_type::key_of(_base));
+    typename index_type::const_ptr idx = index_type::grow(_index, _base, _holidays, a, b);
+    if(idx != _index) {
+      _index = std::move(idx);
+      _holidays->index_cache().store(index_type::key_of(_base), _index);
+    }
+  }
+
+  //! moves the base scale to value \a v
+  void move_base_to(long v) {
+    long n = v - _base.value();
+    if(n > 0)
+      _base += static_cast<unsigned long>(n);
+    else if(n < 0)
+      _base -= static_cast<unsigned long>(-n);
+  }
   
   void back_to_non_holiday() {
-    if(_holidays)
-      while(_holidays->is_holiday(detail::helper<BaseScale>::date(_base.get())))
-        --(*_base);
+    if(!_holidays)
+      return;
+    long v = _base.value();
+    ensure_index(v, v);
+    if(!_index->is_holiday(v))
+      return;
+    while(_index->rank(v) == 0)
+      ensure_index(_index->lo() - 1, v);
+    move_base_to(_index->select(_index->rank(v) - 1));
   }
   
   void advance_to_non_holiday() {
-    if(_holidays)
-      while(_holidays->is_holiday(detail::helper<BaseScale>::date(_base.get())))
-        ++(*_base);
+    if(!_holidays)
+      return;
+    long v = _base.value();
+    ensure_index(v, v);
+    if(!_index->is_holiday(v))
+      return;
+    while(_index->rank(v) >= _index->non_holidays())
+      ensure_index(v, _index->hi());
+    move_base_to(_index->select(_index->rank(v)));
   }
 
   void update_position() {
     if(!_holidays) {
-      _position = _base->value();
+      _position = _base.value();
       return;
     }
-
-    BaseScale z = _base->reference();
-    while(_holidays->is_holiday(detail::helper<BaseScale>::date(&z)))
-      --z;
-
-    _position = *_base - z;
     
-    if(*_base == z)
-      return;
-    else if(_base->value() > z.value()) {
-      while(z != *_base) {
-        ++z;
-        _position -= static_cast<long>(_holidays->is_holiday(detail::helper<BaseScale>::date(&z)));
-      }
-    }
-    else {
-      while(z != *_base) {
-        --z;
-        _position += static_cast<long>(_holidays->is_holiday(detail::helper<BaseScale>::date(&z)));
-      }
-    }
+    // non-holidays in (reference, current] once both are snapped back to a non-holiday
+    long v = _base.value();
+    ensure_index(std::min(v, 0L), std::max(v, 0L));
+    _position = _index->rank(v + 1) - _index->rank(1);
   }
   
 };
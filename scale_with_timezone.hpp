@@ -2,12 +2,52 @@
 #define TIMESCALES_SCALE_WITH_TIMEZONE_HPP
 
 #include "timescale.hpp"
+#include "scale_simple.hpp"
+#include "zone_table.hpp"
 
 namespace timescales {
 
+namespace detail {
+
+//! Utc times and positions of a calculator, from a start at \a start microseconds since 1970-01-01 in the zone \a tz.
+/*! This one goes through the local_date_time interface of the calculator, one position at a time.
+ */
+template<class Calculator>
+struct calculator_bulk {
+  static int64_t utc_microseconds(const time_zone_const_ptr& tz, int64_t start, long position) {
+    return epoch_microseconds(Calculator::local_time(local_date_time(from_epoch_microseconds(start), tz), position).utc_time());
+  }
+
+  static long position(const time_zone_const_ptr& tz, int64_t start, int64_t utc) {
+    return Calculator::position_from_utc_time(local_date_time(from_epoch_microseconds(start), tz), from_epoch_microseconds(utc));
+  }
+
+  static void utc_time(const time_zone_const_ptr& tz, int64_t start, long position, long step, ptime* out, size_t n) {
+    const local_date_time start_time(from_epoch_microseconds(start), tz);
+    for(size_t i=0; i<n; ++i, position+=step)
+      out[i] = Calculator::local_time(start_time, position).utc_time();
+  }
+
+  static void utc_microseconds(const time_zone_const_ptr& tz, int64_t start, long position, long step, int64_t* out, size_t n) {
+    const local_date_time start_time(from_epoch_microseconds(start), tz);
+    for(size_t i=0; i<n; ++i, position+=step)
+      out[i] = epoch_microseconds(Calculator::local_time(start_time, position).utc_time());
+  }
+
+  //! false, the positions of the times are found by walking the scale
+  static bool positions(const time_zone_const_ptr&, int64_t, long, const int64_t*, int64_t*, size_t) {
+    return false;
+  }
+};
+
+}
+
 
 //! The scale_with_timezone class defines a timescale that takes into account time zone information. 
-/*! 
+/*! The calendar calculators convert between utc and local time with the zone_table of the zone: the first 
+ *  conversion in a zone samples the offsets of the three years around it, and times further away extend 
+ *  the table. Only the years given to zone_table::set_years(), 1970 to 2050 by default, are tabulated; 
+ *  the other times are converted by local_date_time.
  */
 template<class Calculator, class Labeler>
 class scale_with_timezone : public detail::timescale<scale_with_timezone<Calculator, Labeler> > {
@@ -32,9 +72,7 @@ public:
    *  \param freq   frequency
    *  \param tz pointer to timezone
    */
-  explicit scale_with_timezone(const ptime& start, long frequency=1, time_zone_const_ptr tz = nullptr) : _frequency(frequency), _start(start, tz), _position(0) { 
-    if(start.is_special())
-      throw std::logic_error("the start time cannot be a special value");
+  explicit scale_with_timezone(const ptime& start, long frequency=1, time_zone_const_ptr tz = nullptr) : _frequency(frequency), _start(anchor(start)), _zone(tz), _position(0) { 
     if(_frequency <= 0)
       throw std::logic_error("frequency must be positive");
   }
@@ -43,9 +81,7 @@ public:
   /*! \param start start anchor (local time)
    *  \param freq  frequency
    */
-  explicit scale_with_timezone(const local_date_time& start, long frequency=1) : _frequency(frequency), _start(start), _position(0) { 
-    if(start.is_special())
-      throw std::logic_error("the start time cannot be a special value");
+  explicit scale_with_timezone(const local_date_time& start, long frequency=1) : _frequency(frequency), _start(anchor(start)), _zone(start.zone()), _position(0) { 
     if(_frequency <= 0)
       throw std::logic_error("frequency must be positive");
   }
@@ -56,11 +92,10 @@ public:
    *  \param freq   frequency
    *  \param tzname timezone name
    */
-  scale_with_timezone(const ptime& tm, const ptime& start, long frequency=1, time_zone_const_ptr tz = nullptr) : _frequency(frequency), _start(start, tz) {
+  scale_with_timezone(const ptime& tm, const ptime& start, long frequency=1, time_zone_const_ptr tz = nullptr) : _frequency(frequency), _zone(tz) {
     if(tm.is_special())
       throw std::logic_error("the time to point to cannot be a special value");
-    if(_start.is_special())
-      _start = local_date_time(tm, tz);
+    _start = detail::epoch_microseconds(start.is_special() ? tm : start);
     if(_frequency <= 0)
       throw std::logic_error("frequency must be positive");
     update_position_from_utc_time(tm);
@@ -71,11 +106,10 @@ public:
    *  \param start start anchor (local time)
    *  \param freq   frequency
    */
-  scale_with_timezone(const ptime& tm, const local_date_time& start, long frequency=1) : _frequency(frequency), _start(start) {
+  scale_with_timezone(const ptime& tm, const local_date_time& start, long frequency=1) : _frequency(frequency), _zone(start.zone()) {
     if(tm.is_special())
       throw std::logic_error("the time to point to cannot be a special value");
-    if(_start.is_special())
-      _start = local_date_time(tm, start.zone());
+    _start = detail::epoch_microseconds(start.is_special() ? tm : start.utc_time());
     if(_frequency <= 0)
       throw std::logic_error("frequency must be positive");
     update_position_from_utc_time(tm);
@@ -86,11 +120,12 @@ public:
    *  \param start      start anchor (local time)
    *  \param freq       frequency
    */
-  scale_with_timezone(const local_date_time& tm, const local_date_time& start, long frequency=1) : _frequency(frequency), _start(start) {
+  scale_with_timezone(const local_date_time& tm, const local_date_time& start, long frequency=1) : _frequency(frequency) {
     if(tm.is_special())
       throw std::logic_error("the time to point to cannot be a special value");
-    if(_start.is_special())
-      _start = tm;
+    const local_date_time& start_time = start.is_special() ? tm : start;
+    _start = detail::epoch_microseconds(start_time.utc_time());
+    _zone = start_time.zone();
     if(_frequency <= 0)
       throw std::logic_error("frequency must be positive");
     update_position_from_utc_time(tm.utc_time());
@@ -99,7 +134,12 @@ public:
   //! Copy constructor
   /*! \param rhs other instance
    */
-  scale_with_timezone(const scale_type& rhs) : _frequency(rhs._frequency), _start(rhs._start), _position(rhs._position) { }
+  scale_with_timezone(const scale_type& rhs) : _frequency(rhs._frequency), _start(rhs._start), _zone(rhs._zone), _position(rhs._position) { }
+
+  //! Move constructor
+  /*! \param rhs other instance
+   */
+  scale_with_timezone(scale_type&& rhs) noexcept : _frequency(rhs._frequency), _start(rhs._start), _zone(std::move(rhs._zone)), _position(rhs._position) { }
   
   //! Shifted copy constructor
   /*! \param n      shift scale by \a n periods
@@ -107,7 +147,7 @@ public:
    */
   scale_with_timezone(ssize_t n, const scale_type& rhs) : scale_with_timezone((rhs + n).local_time(), rhs) { }
 
-  scale_with_timezone(boost::gregorian::special_values, const scale_type& rhs) : _frequency(rhs._frequency), _start(rhs._start) { 
+  scale_with_timezone(boost::gregorian::special_values, const scale_type& rhs) : _frequency(rhs._frequency), _start(rhs._start), _zone(rhs._zone) { 
     throw std::logic_error("the start time cannot be a special value");
   }  
   
@@ -115,7 +155,7 @@ public:
   /*! \param ts     shift scale to this ptime
    *  \param rhs    other instance
    */
-  scale_with_timezone(const ptime& tm, const scale_type& rhs) : _frequency(rhs._frequency), _start(rhs._start) {
+  scale_with_timezone(const ptime& tm, const scale_type& rhs) : _frequency(rhs._frequency), _start(rhs._start), _zone(rhs._zone) {
     update_position_from_utc_time(tm);
   }
   
@@ -123,7 +163,7 @@ public:
   /*! \param ts     shift scale to this local_date_time
    *  \param rhs    other instance
    */
-  scale_with_timezone(const local_date_time& tm, const scale_type& rhs) : _frequency(rhs._frequency), _start(rhs._start) {
+  scale_with_timezone(const local_date_time& tm, const scale_type& rhs) : _frequency(rhs._frequency), _start(rhs._start), _zone(rhs._zone) {
     if(tm.is_special())
       throw std::logic_error("the time to point to cannot be a special value");
     update_position_from_utc_time(tm.utc_time());
@@ -134,7 +174,7 @@ public:
   // special instances //
   //                   //  
 
-  scale_type reference() const { return scale_type(_start, *this); }
+  scale_type reference() const { return scale_type(start_time(), *this); }
 
   
   //            //
@@ -145,6 +185,16 @@ public:
     _position = rhs._position;
     _frequency = rhs._frequency;
     _start = rhs._start;
+    _zone = rhs._zone;
+    return *this;
+  }
+
+  //! move assignment
+  inline scale_type& operator= (scale_type&& rhs) noexcept { 
+    _position = rhs._position;
+    _frequency = rhs._frequency;
+    _start = rhs._start;
+    _zone = std::move(rhs._zone);
     return *this;
   }
 
@@ -219,7 +269,7 @@ public:
 
   //! instances difference
   long operator- (const scale_type& rhs) const { 
-    return _position - scale_type(rhs.utc_time(), _start, _frequency)._position; 
+    return _position - scale_type(rhs.utc_time(), *this)._position; 
   }
   
   // LCOV_EXCL_START
@@ -233,11 +283,27 @@ public:
   //              //
   
   local_date_time local_time() const override {
-    return Calculator::local_time(_start, _position * _frequency);
+    return local_date_time(utc_time(), _zone);
   }
   
   ptime utc_time() const override { 
-    return local_time().utc_time();
+    return detail::from_epoch_microseconds(detail::calculator_bulk<Calculator>::utc_microseconds(_zone, _start, _position * _frequency));
+  }
+
+  //! writes the utc times of the \a n values starting at the current one to \a out
+  void utc_time_into(ptime* out, size_t n) const {
+    detail::calculator_bulk<Calculator>::utc_time(_zone, _start, _position * _frequency, _frequency, out, n);
+  }
+
+  //! writes the utc times of the \a n values starting at the current one to \a out, in microseconds since 1970-01-01
+  void utc_microseconds_into(int64_t* out, size_t n) const {
+    detail::calculator_bulk<Calculator>::utc_microseconds(_zone, _start, _position * _frequency, _frequency, out, n);
+  }
+
+  //! writes the values of the scale at the \a n utc times \a utc_us, in microseconds since 1970-01-01, to \a out
+  void positions_into(const int64_t* utc_us, int64_t* out, size_t n) const {
+    if(!detail::calculator_bulk<Calculator>::positions(_zone, _start, _frequency, utc_us, out, n))
+      scale_type_base::positions_into(utc_us, out, n);
   }
   
   
@@ -245,8 +311,25 @@ public:
   // string representation //
   //                       //
   
+  //! writes the label of the current period to \a out, max_label_size chars long, returns its length
+  size_t label(char* out) const {
+    const local_date_time t(local_time());
+    return Labeler::write(out, t, t);
+  }
+
+  //! time given to the labeler for the current period
+  local_date_time label_time() const { return local_time(); }
+
+  //! writes the label of the period from \a t to \a next to \a out, returns its length
+  static size_t write_label(typename Labeler::cursor_type& cursor, char* out, const local_date_time& t, const local_date_time& next) {
+    return Labeler::write_with(cursor, out, t, t);
+  }
+
   //! string representation
-  std::string to_string() const { return Labeler::str(local_time(), local_time()); }
+  std::string to_string() const {
+    char buffer[max_label_size];
+    return std::string(buffer, label(buffer));
+  }
 
   
   //! ostream operator <<
@@ -256,13 +339,32 @@ public:
   }
   
 private:
-  long              _frequency;
-  local_date_time   _start;
-  long              _position;
+  long                 _frequency;
+  int64_t              _start;     // utc microseconds since 1970-01-01
+  time_zone_const_ptr  _zone;
+  long                 _position;
+
+  //! utc time of \a start in microseconds since 1970-01-01
+  static int64_t anchor(const ptime& start) {
+    if(start.is_special())
+      throw std::logic_error("the start time cannot be a special value");
+    return detail::epoch_microseconds(start);
+  }
+
+  //! utc time of \a start in microseconds since 1970-01-01
+  static int64_t anchor(const local_date_time& start) {
+    if(start.is_special())
+      throw std::logic_error("the start time cannot be a special value");
+    return detail::epoch_microseconds(start.utc_time());
+  }
 
+  //! start anchor as a local time
+  local_date_time start_time() const {
+    return local_date_time(detail::from_epoch_microseconds(_start), _zone);
+  }
   
   void update_position_from_utc_time(const ptime& p) {
-    _position = Calculator::position_from_utc_time(_start, p) / _frequency;
+    _position = detail::calculator_bulk<Calculator>::position(_zone, _start, detail::epoch_microseconds(p)) / _frequency;
   }
 }; 
   
@@ -287,8 +389,7 @@ struct simple_calculator : period_calculator_base {
   static_assert(Multiplier > 0, "Multiplier in a simple_calculator must be positive.");
 
   inline static local_date_time local_time(const local_date_time& start, long position) {
-    auto d = detail::duration_from_microseconds(position * Multiplier);
-    return start + d.first + d.second;
+    return local_date_time(detail::from_epoch_microseconds(detail::epoch_microseconds(start.utc_time()) + position * Multiplier), start.zone());
   }
 
   inline static long position_from_utc_time(const local_date_time& start, const ptime& p) {
@@ -297,80 +398,225 @@ struct simple_calculator : period_calculator_base {
 };
 
 
-//! Years calculator.
-struct years_calculator : period_calculator_base {
+namespace detail {
 
-  inline static local_date_time local_time(const local_date_time& start, long position) {
-    return start + boost::gregorian::years(position);
+//! Positions of a simple_calculator are evenly spaced in utc.
+template<int64_t Multiplier>
+struct calculator_bulk<simple_calculator<Multiplier> > {
+  static int64_t utc_microseconds(const time_zone_const_ptr&, int64_t start, long position) {
+    return start + position * Multiplier;
   }
 
-  inline static long position_from_utc_time(const local_date_time& start, const ptime& p) {
-    local_date_time plocal(p, start.zone());
-    long pos = plocal.local_time().date().year() - start.local_time().date().year();
-    if(local_time(start, pos) > plocal)
-      --pos;
-    return pos;
+  static long position(const time_zone_const_ptr&, int64_t start, int64_t utc) {
+    return (utc - start) / Multiplier;
+  }
+
+  static void utc_time(const time_zone_const_ptr&, int64_t start, long position, long step, ptime* out, size_t n) {
+    const ptime t0 = from_epoch_microseconds(start);
+    int64_t t = position * Multiplier;
+    for(size_t i=0; i<n; ++i, t+=step*Multiplier)
+      out[i] = t0 + boost::posix_time::microseconds(t);
+  }
+
+  static void utc_microseconds(const time_zone_const_ptr&, int64_t start, long position, long step, int64_t* out, size_t n) {
+    fill_grid(start + position * Multiplier, step * Multiplier, out, n);
+  }
+
+  static bool positions(const time_zone_const_ptr&, int64_t start, long step, const int64_t* utc_us, int64_t* out, size_t n) {
+    // truncating by Multiplier then by step is truncating by their product
+    bucket_grid(utc_us, start, step * Multiplier, out, n);
+    return true;
   }
 };
 
+}
+
+
+namespace detail {
+
+//! microseconds in a day
+static const int64_t day_microseconds = 86400000000LL;
+
+//! Calculator of the periods of a \a Calendar, stepping in local time and kept at the local time of day of the start.
+/*! The \a Calendar gives the local time in microseconds since 1970-01-01 some positions after a start, with
+ *  shift(start, position), and a position at most one period after the one of a local time, with guess(start, time).
+ *  The conversions between utc and local time go through the zone_table of the zone, and back to local_date_time
+ *  outside of its span or around its transitions.
+ */
+template<class Calendar>
+struct local_calculator : period_calculator_base {
 
-//! Months calculator.
-struct months_calculator : period_calculator_base {
-  
   inline static local_date_time local_time(const local_date_time& start, long position) {
-    return start + boost::gregorian::months(position);
+    int64_t utc;
+    if(utc_microseconds(start.zone(), epoch_microseconds(start.utc_time()), position, utc))
+      return local_date_time(from_epoch_microseconds(utc), start.zone());
+    const int64_t start_local = epoch_microseconds(start.local_time());
+    return start + boost::gregorian::days((Calendar::shift(start_local, position) - start_local) / day_microseconds);
   }
 
   inline static long position_from_utc_time(const local_date_time& start, const ptime& p) {
-    local_date_time plocal(p, start.zone());
-    
-    long pos = plocal.local_time().date().year() - start.local_time().date().year();
-//     if(years_calculator::local_time(start, pos) > plocal)
-//       --pos;
-    pos = 12 * pos + p.date().month() - start.local_time().date().month();
-
-    if(local_time(start, pos) > plocal)
-      --pos;
-    return pos;
+    return position_from_utc(start.zone(), epoch_microseconds(start.utc_time()), epoch_microseconds(p));
+  }
+
+  //! sets \a utc to the utc time \a position periods after the utc time \a start in \a tz, both in microseconds since
+  //! 1970-01-01; false when the zone table cannot tell
+  inline static bool utc_microseconds(const time_zone_const_ptr& tz, int64_t start, long position, int64_t& utc) {
+    int64_t start_local;
+    return local_from_utc(tz, start, start_local)
+        && utc_from_local(tz, Calendar::shift(start_local, position), utc);
+  }
+
+  //! position of the utc time \a pu from the utc time \a start in \a tz, both in microseconds since 1970-01-01
+  inline static long position_from_utc(const time_zone_const_ptr& tz, int64_t start, int64_t pu) {
+    int64_t start_local, local, utc;
+    if(local_from_utc(tz, start, start_local) && local_from_utc(tz, pu, local)) {
+      const long pos = Calendar::guess(start_local, local);
+      if(utc_from_local(tz, Calendar::shift(start_local, pos), utc))
+        return utc > pu ? pos - 1 : pos;
+    }
+    const local_date_time start_time(from_epoch_microseconds(start), tz);
+    const local_date_time plocal(from_epoch_microseconds(pu), tz);
+    const long pos = Calendar::guess(epoch_microseconds(start_time.local_time()), epoch_microseconds(plocal.local_time()));
+    return local_time(start_time, pos) > plocal ? pos - 1 : pos;
   }
 };
 
+//! \a a / \a b rounded toward minus infinity, for a positive \a b
+inline int64_t floor_div(int64_t a, int64_t b) {
+  return (a >= 0 ? a : a - b + 1) / b;
+}
 
-//! Weeks calculator.
-struct weeks_calculator : period_calculator_base {
+//! Calendar of periods of \a Days days.
+template<int64_t Days>
+struct days_calendar {
+  static const int64_t period = Days * day_microseconds;
 
-  inline static local_date_time local_time(const local_date_time& start, long position) {
-    return start + boost::gregorian::days(7 * position);
+  static int64_t shift(int64_t start, long position) {
+    return start + Days * position * day_microseconds;
   }
 
-  inline static long position_from_utc_time(const local_date_time& start, const ptime& p) {
-    local_date_time plocal(p, start.zone());
-    long pos = (plocal.local_time().date() - start.local_time().date()).days() / 7;
+  static long guess(int64_t start, int64_t local) {
+    return static_cast<long>(floor_div(floor_div(local, day_microseconds) - floor_div(start, day_microseconds), Days));
+  }
+};
+
+//! Calendar of periods of \a Months months, on days counted from 1970-01-01 in local time.
+template<int64_t Months>
+struct months_calendar {
+  static const int64_t period = 0;  // not constant
 
-    if(local_time(start, pos) > plocal)
-      --pos;
-    return pos;
+  static int64_t shift(int64_t start, long position) {
+    const int64_t start_day = floor_div(start, day_microseconds);
+    int64_t y;
+    unsigned m, d;
+    civil_from_days(start_day, y, m, d);
+    return start + (add_months(y, m, d, Months * position) - start_day) * day_microseconds;
+  }
+
+  static long guess(int64_t start, int64_t local) {
+    int64_t y, ly;
+    unsigned m, d, lm, ld;
+    civil_from_days(floor_div(start, day_microseconds), y, m, d);
+    civil_from_days(floor_div(local, day_microseconds), ly, lm, ld);
+    return static_cast<long>(floor_div((ly - y) * 12 + lm - m, Months));
   }
 };
 
+}
+
+
+//! Years calculator.
+struct years_calculator : detail::local_calculator<detail::months_calendar<12> > { };
+
+
+//! Months calculator.
+struct months_calculator : detail::local_calculator<detail::months_calendar<1> > { };
+
+
+//! Weeks calculator.
+struct weeks_calculator : detail::local_calculator<detail::days_calendar<7> > { };
+
 
 //! Days calculator.
-struct days_calculator : period_calculator_base {
+struct days_calculator : detail::local_calculator<detail::days_calendar<1> > { };
 
-  inline static local_date_time local_time(const local_date_time& start, long position) {
-    return start + boost::gregorian::days(position);
-  }
 
-  inline static long position_from_utc_time(const local_date_time& start, const ptime& p) {
-    local_date_time plocal(p, start.zone());
-    long pos = (plocal.local_time().date() - start.local_time().date()).days();
-    
-    if(local_time(start, pos) > plocal)
-      --pos;
-    return pos;
+namespace detail {
+
+//! Utc times and positions of a local_calculator, with integer offsets in zones whose offset does not change.
+/*! The positions of a calendar of a constant period are those of a grid in utc; the other calendars compare
+ *  local times in microseconds. Times outside of the span of the zone table go back to the calculator.
+ */
+template<class Calendar>
+struct local_calculator_bulk {
+  typedef local_calculator<Calendar>  calculator;
+
+  static int64_t utc_microseconds(const time_zone_const_ptr& tz, int64_t start, long position) {
+    int64_t utc;
+    if(calculator::utc_microseconds(tz, start, position, utc))
+      return utc;
+    return epoch_microseconds(calculator::local_time(local_date_time(from_epoch_microseconds(start), tz), position).utc_time());
+  }
+
+  static long position(const time_zone_const_ptr& tz, int64_t start, int64_t utc) {
+    return calculator::position_from_utc(tz, start, utc);
+  }
+
+  static void utc_time(const time_zone_const_ptr& tz, int64_t start, long position, long step, ptime* out, size_t n) {
+    for(size_t i=0; i<n; ++i, position+=step)
+      out[i] = from_epoch_microseconds(utc_microseconds(tz, start, position));
+  }
+
+  static void utc_microseconds(const time_zone_const_ptr& tz, int64_t start, long position, long step, int64_t* out, size_t n) {
+    fixed_offset fixed;
+    if(fixed_offset_of(tz, start, fixed) && fixed.covers(start)) {
+      const int64_t start_local = start + fixed.offset;
+      for(size_t i=0; i<n; ++i, position+=step) {
+        const int64_t utc = Calendar::shift(start_local, position) - fixed.offset;
+        out[i] = fixed.covers(utc) ? utc : utc_microseconds(tz, start, position);
+      }
+      return;
+    }
+    for(size_t i=0; i<n; ++i, position+=step)
+      out[i] = utc_microseconds(tz, start, position);
+  }
+
+  static bool positions(const time_zone_const_ptr& tz, int64_t start, long step, const int64_t* utc_us, int64_t* out, size_t n) {
+    fixed_offset fixed;
+    if(!fixed_offset_of(tz, start, fixed) || !fixed.covers(start))
+      return false;
+    const int64_t start_local = start + fixed.offset;
+    if(Calendar::period != 0) {
+      // truncating the floor by step is truncating by their product after the start
+      bucket_grid(utc_us, start, Calendar::period * step, out, n);
+      for(size_t i=0; i<n; ++i) {
+        if(!fixed.covers(utc_us[i]))
+          out[i] = calculator::position_from_utc(tz, start, utc_us[i]) / step;
+        else if(utc_us[i] < start)
+          out[i] = floor_div(utc_us[i] - start, Calendar::period) / step;
+      }
+      return true;
+    }
+    for(size_t i=0; i<n; ++i) {
+      const int64_t local = utc_us[i] + fixed.offset;
+      long pos = Calendar::guess(start_local, local);
+      const int64_t shifted = Calendar::shift(start_local, pos);
+      if(!fixed.covers(utc_us[i]) || !fixed.covers(shifted - fixed.offset))
+        pos = calculator::position_from_utc(tz, start, utc_us[i]);
+      else if(shifted > local)
+        --pos;
+      out[i] = pos / step;
+    }
+    return true;
   }
 };
 
+template<> struct calculator_bulk<years_calculator> : local_calculator_bulk<months_calendar<12> > { };
+template<> struct calculator_bulk<months_calculator> : local_calculator_bulk<months_calendar<1> > { };
+template<> struct calculator_bulk<weeks_calculator> : local_calculator_bulk<days_calendar<7> > { };
+template<> struct calculator_bulk<days_calculator> : local_calculator_bulk<days_calendar<1> > { };
+
+}
 
 }
 
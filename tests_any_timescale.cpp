@@ -0,0 +1,105 @@
+
+#include <boost/test/unit_test.hpp>
+#include <iostream>
+#include "timescales.hpp"
+
+// using namespace timescales;
+
+using boost::posix_time::ptime;
+using boost::gregorian::date;
+using boost::posix_time::time_duration;
+
+using namespace timescales;
+
+
+BOOST_AUTO_TEST_SUITE(tests_scales)
+
+
+struct days_since_start {
+  ptime start;
+  long operator()(const utc_days_scale& sc) const { return 1000 + (sc.utc_time() - start).hours() / 24; }
+  template<class Scale>
+  long operator()(const Scale& sc) const { return (sc.utc_time() - start).hours() / 24; }
+};
+
+
+BOOST_AUTO_TEST_CASE(test_any_timescale) {
+  const ptime p(date(2000,1,3));
+  const utc_days_scale uds(p);
+  const days_scale ds(p);
+  const business_days bd(p, 1, nullptr, holidays_const_ptr(new holidays_from_vector({date(2000,1,4)})));
+  
+  const any_timescale a(uds), b(ds), c(bd);
+  
+  { // held instance
+    BOOST_CHECK_EQUAL( a.index(), any_timescale::index_of<utc_days_scale>::value );
+    BOOST_CHECK_EQUAL( c.index(), any_timescale::index_of<business_days>::value );
+    BOOST_CHECK( a.get<utc_days_scale>() && *a.get<utc_days_scale>() == uds );
+    BOOST_CHECK( !a.get<days_scale>() );
+    BOOST_CHECK( c.get<business_days>() && *c.get<business_days>() == bd );
+    BOOST_CHECK( &a.base() == a.get<utc_days_scale>() );
+    BOOST_CHECK_EQUAL( c.base().utc_time(), bd.utc_time() );
+    BOOST_CHECK_EQUAL( a.visit<long>(days_since_start{p}), 1000 );
+    BOOST_CHECK_EQUAL( (c + 2).visit<long>(days_since_start{p}), 3 );
+  }
+  { // copy and assignment
+    any_timescale x(a);
+    BOOST_CHECK_EQUAL( x, a );
+    x = c;
+    BOOST_CHECK_EQUAL( x, c );
+    x = x;
+    BOOST_CHECK_EQUAL( x, c );
+    x = weekdays_scale(p);
+    BOOST_CHECK_EQUAL( x.index(), any_timescale::index_of<weekdays_scale>::value );
+    x = utc_seconds_ns_scale(p);
+    BOOST_CHECK_EQUAL( x.index(), any_timescale::index_of<utc_seconds_ns_scale>::value );
+    BOOST_CHECK_EQUAL( (x + 3).utc_time(), p + time_duration(0,0,3) );
+  }
+  { // move
+    BOOST_CHECK( std::is_nothrow_move_constructible<any_timescale>::value );
+    BOOST_CHECK( std::is_nothrow_move_assignable<any_timescale>::value );
+    any_timescale x(c), y(a);
+    any_timescale z(std::move(x));
+    BOOST_CHECK_EQUAL( z, c );
+    z = std::move(y);
+    BOOST_CHECK_EQUAL( z, a );
+    z = any_timescale(c + 2);
+    BOOST_CHECK_EQUAL( z, c + 2 );
+  }
+  { // arithmetic
+    any_timescale x(c);
+    BOOST_CHECK_EQUAL( (++x).utc_time(), (bd + 1).utc_time() );
+    BOOST_CHECK_EQUAL( (x++).utc_time(), (bd + 1).utc_time() );
+    BOOST_CHECK_EQUAL( x.utc_time(), (bd + 2).utc_time() );
+    BOOST_CHECK_EQUAL( (--x).utc_time(), (bd + 1).utc_time() );
+    BOOST_CHECK_EQUAL( (x--).utc_time(), (bd + 1).utc_time() );
+    BOOST_CHECK_EQUAL( x, c );
+    x += 10;
+    BOOST_CHECK_EQUAL( x - c, 10 );
+    x -= 15;
+    BOOST_CHECK_EQUAL( x - c, -5 );
+    BOOST_CHECK_EQUAL( (c + 7).utc_time(), (bd + 7).utc_time() );
+    BOOST_CHECK_EQUAL( (c - 7).utc_time(), (bd - 7).utc_time() );
+    BOOST_CHECK_EQUAL( (b + 3).local_time(), (ds + 3).local_time() );
+  }
+  { // comparison
+    BOOST_CHECK( a != b );
+    BOOST_CHECK( a == any_timescale(utc_days_scale(p)) );
+    BOOST_CHECK( a != a + 1 );
+    BOOST_CHECK_THROW( a - b, std::bad_cast );
+  }
+  { // string representation
+    std::stringstream out1, out2;
+    out1 << c;
+    out2 << bd;
+    BOOST_CHECK_EQUAL( out1.str(), out2.str() );
+    BOOST_CHECK_EQUAL( b.to_string(), ds.to_string() );
+  }
+}
+
+
+BOOST_AUTO_TEST_SUITE_END()
+
+
+
+
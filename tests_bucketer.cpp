@@ -0,0 +1,65 @@
+#include <boost/test/unit_test.hpp>
+#include <iostream>
+#include "timescales.hpp"
+
+// using namespace timescales;
+
+using boost::posix_time::ptime;
+using boost::gregorian::date;
+using boost::posix_time::time_duration;
+
+using namespace timescales;
+
+
+BOOST_AUTO_TEST_SUITE(tests_scales)
+
+
+BOOST_AUTO_TEST_CASE(test_bucketer) {
+  const ptime p(date(2000,1,3));   // a Monday
+  
+  { // classification and callbacks
+    std::vector<ptime> opened, closed;
+    bucketer<business_days> b(business_days(p), 
+                              [&opened](const business_days& sc) { opened.push_back(sc.utc_time()); },
+                              [&closed](const business_days& sc) { closed.push_back(sc.utc_time()); });
+    BOOST_CHECK( !b.is_open() );
+
+    BOOST_CHECK_EQUAL( b.push(p + time_duration(1,0,0)), 0 );
+    BOOST_CHECK( b.is_open() );
+    BOOST_CHECK_EQUAL( b.push(p + time_duration(23,0,0)), 0 );
+    BOOST_CHECK_EQUAL( opened.size(), 1 );
+    BOOST_CHECK_EQUAL( closed.size(), 0 );
+    BOOST_CHECK_EQUAL( b.start_microseconds(), detail::epoch_microseconds(p) );
+    BOOST_CHECK_EQUAL( b.end_microseconds(), detail::epoch_microseconds(p + time_duration(24,0,0)) );
+
+    BOOST_CHECK_EQUAL( b.push(p + time_duration(25,0,0)), 1 );                              // next period
+    BOOST_CHECK_EQUAL( b.push(ptime(date(2000,1,8), time_duration(12,0,0))), 4 );           // saturday, still friday
+    BOOST_CHECK_EQUAL( b.push(ptime(date(2000,1,12))), 7 );                                  // skips empty periods
+    BOOST_CHECK_EQUAL( b.current().utc_time(), ptime(date(2000,1,12)) );
+    b.close();
+    BOOST_CHECK( !b.is_open() );
+    b.close();
+
+    std::vector<ptime> expected_opened = {p, p + time_duration(24,0,0), ptime(date(2000,1,7)), ptime(date(2000,1,12))};
+    BOOST_CHECK( opened == expected_opened );
+    BOOST_CHECK( closed == expected_opened );
+  }
+  { // same values as the constructors
+    const minutes_scale sc(p - time_duration(2,0,0), 5);
+    bucketer<minutes_scale> b(sc);
+    for(int s=-3000; s<3000; s+=7) {
+      ptime t = p + boost::posix_time::seconds(s);
+      BOOST_CHECK_EQUAL( b.push(t), minutes_scale(t, sc).value() );
+    }
+    b.push(p - time_duration(1,0,0));   // back in time
+    BOOST_CHECK_EQUAL( b.current().value(), minutes_scale(p - time_duration(1,0,0), sc).value() );
+  }
+  { // without callbacks
+    bucketer<utc_days_scale> b((utc_days_scale(p)));
+    BOOST_CHECK_EQUAL( b.push(detail::epoch_microseconds(p + time_duration(49,0,0))), 2 );
+    BOOST_CHECK_NO_THROW( b.close() );
+  }
+}
+
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -49,6 +49,31 @@ BOOST_AUTO_TEST_CASE(test_holidays) {
     BOOST_CHECK(  hfv.is_holiday(date(2011, 4, 1)) );
     BOOST_CHECK( !hfv.is_holiday(date(2011, 4, 2)) );
   }
+  {
+    std::vector<date> vd;
+    vd.push_back(date(2012, 2, 29));
+    vd.push_back(date(2008, 12, 31));
+    vd.push_back(date(2009, 1, 1));
+    vd.push_back(date(2012, 12, 31));
+
+    holidays_from_vector hfv(vd);
+
+    BOOST_CHECK(  hfv.is_holiday(date(2008, 12, 31)) );
+    BOOST_CHECK(  hfv.is_holiday(date(2009, 1, 1)) );
+    BOOST_CHECK(  hfv.is_holiday(date(2012, 2, 29)) );
+    BOOST_CHECK(  hfv.is_holiday(date(2012, 12, 31)) );
+    BOOST_CHECK( !hfv.is_holiday(date(2008, 1, 1)) );
+    BOOST_CHECK( !hfv.is_holiday(date(2012, 3, 1)) );
+    // outside of the covered years
+    BOOST_CHECK( !hfv.is_holiday(date(2007, 12, 31)) );
+    BOOST_CHECK( !hfv.is_holiday(date(2013, 1, 1)) );
+    BOOST_CHECK( !hfv.is_holiday(date(1400, 1, 1)) );
+    BOOST_CHECK( !hfv.is_holiday(date(9999, 12, 31)) );
+    BOOST_CHECK( !hfv.is_holiday(date(boost::gregorian::not_a_date_time)) );
+
+    holidays_from_vector empty((std::vector<date>()));
+    BOOST_CHECK( !empty.is_holiday(date(2011, 1, 1)) );
+  }
   {
     // get temp path
     boost::filesystem::path path;
@@ -84,6 +109,81 @@ BOOST_AUTO_TEST_CASE(test_holidays) {
     {
       BOOST_CHECK_THROW(hff3.reset(new holidays_from_file(path.string())), std::runtime_error);
     }  
+    {
+      boost::filesystem::ofstream fo(path);
+      fo << "# header\r\n  20110101\t# new year\r\n\t\r\n20120229  \n20110401";
+      fo.close();
+      std::vector<date> vd;
+      BOOST_CHECK_NO_THROW( vd = holidays_from_file::vector_from_file(path.string()) );
+      BOOST_CHECK( vd == std::vector<date>({date(2011, 1, 1), date(2012, 2, 29), date(2011, 4, 1)}) );
+      boost::filesystem::remove(path);
+    }
+    {
+      const std::vector<std::pair<std::string, std::string> > bad_files {
+        { "20110101\n\n20110229\n", "Cannot read a valid date from '20110229' at line 3" },
+        { "20110101\n2011010\n", "Cannot read a valid date from '2011010' at line 2" },
+        { "201101011\n", "Cannot read a valid date from '201101011' at line 1" },
+        { "20110101 20110102\n", "Cannot read a valid date from '2011010120110102' at line 1" },
+        { "2011-01-01\n", "Cannot read a valid date from '2011-01-01' at line 1" },
+        { "13990101", "Cannot read a valid date from '13990101' at line 1" },
+      };
+      for(auto it=bad_files.begin(); it!=bad_files.end(); ++it) {
+        boost::filesystem::ofstream fo(path);
+        fo << it->first;
+        fo.close();
+        BOOST_CHECK_EXCEPTION( holidays_from_file::vector_from_file(path.string()), std::runtime_error, 
+                               [&it](const std::runtime_error& err){ return std::string(err.what()).find(it->second) == 0; } );
+        boost::filesystem::remove(path);
+      }
+    }
+  }
+  { // binary calendars
+    boost::filesystem::path path, text_path;
+    while( path.empty() || boost::filesystem::exists(path) || boost::filesystem::exists(text_path) ) {
+      path = boost::filesystem::temp_directory_path();
+      path /= boost::filesystem::unique_path("%%%%-%%%%-%%%%-%%%%");
+      text_path = path.string() + ".txt";
+    }
+
+    const std::vector<date> vd {date(2012, 2, 29), date(2008, 12, 31), date(2009, 1, 1), date(2012, 12, 31)};
+    const holidays_from_vector hfv(vd);
+    BOOST_CHECK_NO_THROW( write_holidays_binary(path.string(), vd) );
+    {
+      holidays_const_ptr hfb( new holidays_from_binary_file(path.string()) );
+      for(date d(2007, 12, 1); d < date(2013, 2, 1); d += boost::gregorian::days(1))
+        BOOST_CHECK_EQUAL( hfb->is_holiday(d), hfv.is_holiday(d) );
+      BOOST_CHECK( !hfb->is_holiday(date(boost::gregorian::not_a_date_time)) );
+      BOOST_CHECK_EQUAL( hfb->count_holidays(date(2008, 1, 1), date(2013, 1, 1)), 4 );
+
+      holidays_composite hc({hfb});
+      detail::holidays_bitmap bitmap;
+      std::vector<holidays_const_ptr> dynamic;
+      hc.flatten(bitmap, dynamic, nullptr);
+      BOOST_CHECK( dynamic.empty() );
+      BOOST_CHECK( bitmap.test(date(2012, 2, 29)) );
+    }
+    {
+      boost::filesystem::ofstream fo(text_path);
+      fo << "20110101\n# comment\n20110401\n";
+      fo.close();
+      BOOST_CHECK_NO_THROW( convert_holidays_file(text_path.string(), path.string()) );
+      holidays_from_binary_file hfb(path.string());
+      BOOST_CHECK(  hfb.is_holiday(date(2011, 1, 1)) );
+      BOOST_CHECK(  hfb.is_holiday(date(2011, 4, 1)) );
+      BOOST_CHECK( !hfb.is_holiday(date(2011, 4, 2)) );
+
+      // a text calendar is not a binary one
+      BOOST_CHECK_THROW( holidays_from_binary_file(text_path.string()), std::runtime_error );
+      boost::filesystem::remove(text_path);
+    }
+    {
+      BOOST_CHECK_NO_THROW( write_holidays_binary(path.string(), std::vector<date>()) );
+      holidays_from_binary_file hfb(path.string());
+      BOOST_CHECK( !hfb.is_holiday(date(2011, 1, 1)) );
+      BOOST_CHECK_EQUAL( hfb.count_holidays(date(2011, 1, 1), date(2012, 1, 1)), 0 );
+    }
+    boost::filesystem::remove(path);
+    BOOST_CHECK_THROW( holidays_from_binary_file(path.string()), std::runtime_error );
   }
   {
     holidays_ptr hfc1( new holidays_from_callback([](const date& d) { return d > date(2010,1,1);}) );
@@ -98,6 +198,66 @@ BOOST_AUTO_TEST_CASE(test_holidays) {
     BOOST_CHECK(  hfc2->is_holiday(date(2010, 1, 1)) );
     BOOST_CHECK( !hfc2->is_holiday(date(2010, 1, 2)) );  
   }
+  {
+    int calls = 0;
+    holidays_ptr hfc( new holidays_from_cached_callback([&calls](const date& d) { ++calls; return d.day() == 1 || d == date(2012, 12, 31); }) );
+
+    BOOST_CHECK_EQUAL( calls, 0 );
+    BOOST_CHECK(  hfc->is_holiday(date(2012, 1, 1)) );
+    BOOST_CHECK_EQUAL( calls, 366 );
+    BOOST_CHECK( !hfc->is_holiday(date(2012, 2, 29)) );
+    BOOST_CHECK(  hfc->is_holiday(date(2012, 12, 31)) );
+    BOOST_CHECK(  hfc->is_holiday(date(2012, 3, 1)) );
+    BOOST_CHECK_EQUAL( calls, 366 );
+    BOOST_CHECK(  hfc->is_holiday(date(2011, 2, 1)) );
+    BOOST_CHECK( !hfc->is_holiday(date(2011, 12, 31)) );
+    BOOST_CHECK_EQUAL( calls, 366 + 365 );
+    BOOST_CHECK(  hfc->is_holiday(date(1400, 1, 1)) );
+    BOOST_CHECK( !hfc->is_holiday(date(9999, 12, 31)) );
+    BOOST_CHECK( !hfc->is_holiday(date(boost::gregorian::not_a_date_time)) );
+  }
+  { // rules
+    using boost::date_time::Monday;
+    using boost::date_time::Saturday;
+    BOOST_CHECK_EQUAL( holiday_rule::easter_sunday(1818), date(1818, 3, 22) );
+    BOOST_CHECK_EQUAL( holiday_rule::easter_sunday(2000), date(2000, 4, 23) );
+    BOOST_CHECK_EQUAL( holiday_rule::easter_sunday(2013), date(2013, 3, 31) );
+    BOOST_CHECK_EQUAL( holiday_rule::easter_sunday(2038), date(2038, 4, 25) );
+    BOOST_CHECK( holiday_rule::nth_weekday(5, Monday, 2).date_in(2011).is_special() );
+    BOOST_CHECK_EQUAL( holiday_rule::nth_weekday(5, Monday, 2).date_in(2016), date(2016, 2, 29) );
+    BOOST_CHECK( holiday_rule::fixed_date(2, 29).date_in(2011).is_special() );
+    BOOST_CHECK_THROW( holiday_rule::fixed_date(2, 30), std::logic_error );
+    BOOST_CHECK_THROW( holiday_rule::fixed_date(13, 1), std::logic_error );
+    BOOST_CHECK_THROW( holiday_rule::nth_weekday(0, Monday, 1), std::logic_error );
+    BOOST_CHECK_THROW( holiday_rule::last_weekday(Monday, 0), std::logic_error );
+    BOOST_CHECK( holiday_rule::fixed_date(1, 1, holiday_rule::nearest_weekday).date_in(1400).is_special() == (date(1400, 1, 1).day_of_week() == Saturday) );
+
+    holidays_const_ptr hfr( new holidays_from_rules({
+      holiday_rule::fixed_date(1, 1, holiday_rule::nearest_weekday),
+      holiday_rule::nth_weekday(3, Monday, 1).between(1986, 9999),
+      holiday_rule::last_weekday(Monday, 5),
+      holiday_rule::fixed_date(7, 4, holiday_rule::nearest_weekday),
+      holiday_rule::easter_offset(-2),
+      holiday_rule::fixed_date(12, 25, holiday_rule::following_monday)
+    }, 2010, 2013) );
+
+    BOOST_CHECK(  hfr->is_holiday(date(2012, 1, 2)) );     // Sunday new year
+    BOOST_CHECK( !hfr->is_holiday(date(2012, 1, 1)) );
+    BOOST_CHECK(  hfr->is_holiday(date(2010, 12, 31)) );   // Saturday new year of the next year
+    BOOST_CHECK( !hfr->is_holiday(date(2011, 1, 1)) );
+    BOOST_CHECK(  hfr->is_holiday(date(2012, 1, 16)) );
+    BOOST_CHECK(  hfr->is_holiday(date(2012, 5, 28)) );
+    BOOST_CHECK(  hfr->is_holiday(date(2015, 7, 3)) );     // outside of the prepared years
+    BOOST_CHECK(  hfr->is_holiday(date(2010, 7, 5)) );
+    BOOST_CHECK(  hfr->is_holiday(date(2013, 3, 29)) );
+    BOOST_CHECK(  hfr->is_holiday(date(2010, 12, 27)) );   // Saturday Christmas
+    BOOST_CHECK(  hfr->is_holiday(date(1986, 1, 20)) );
+    BOOST_CHECK( !hfr->is_holiday(date(1985, 1, 21)) );
+    BOOST_CHECK( !hfr->is_holiday(date(boost::gregorian::not_a_date_time)) );
+    BOOST_CHECK_EQUAL( hfr->count_holidays(date(2012, 1, 1), date(2013, 1, 1)), 6 );
+    BOOST_CHECK_NO_THROW( hfr->is_holiday(date(1400, 1, 1)) );
+    BOOST_CHECK_NO_THROW( hfr->is_holiday(date(9999, 12, 31)) );
+  }
   {
     holidays_ptr hfc1( new holidays_from_callback([](const date& d) { return d > date(2010,1,1);}) );
     holidays_ptr hfc2( new holidays_from_callback([](const date& d) { return d == date(2010,1,1);}) );
@@ -109,6 +269,62 @@ BOOST_AUTO_TEST_CASE(test_holidays) {
     BOOST_CHECK(  hc.is_holiday(date(2010, 1, 2)) );
     BOOST_CHECK(  hc.is_holiday(date(2011, 1, 1)) );  
   }
+  {
+    holidays_const_ptr hfv1( new holidays_from_vector({date(2009, 1, 1), date(2009, 12, 25)}) );
+    holidays_const_ptr hfv2( new holidays_from_vector({date(2001, 7, 4), date(2012, 2, 29)}) );
+    holidays_const_ptr hfc( new holidays_from_callback([](const date& d) { return d == date(2010,1,1);}) );
+    holidays_const_ptr nested( new holidays_composite({hfv2, hfc, holidays_const_ptr(new no_holidays())}) );
+
+    holidays_composite hc({hfv1, nested, holidays_const_ptr()});
+
+    BOOST_CHECK(  hc.is_holiday(date(2009, 1, 1)) );
+    BOOST_CHECK(  hc.is_holiday(date(2009, 12, 25)) );
+    BOOST_CHECK(  hc.is_holiday(date(2001, 7, 4)) );
+    BOOST_CHECK(  hc.is_holiday(date(2012, 2, 29)) );
+    BOOST_CHECK(  hc.is_holiday(date(2010, 1, 1)) );
+    BOOST_CHECK( !hc.is_holiday(date(2000, 7, 4)) );
+    BOOST_CHECK( !hc.is_holiday(date(2009, 1, 2)) );
+    BOOST_CHECK( !hc.is_holiday(date(2011, 1, 1)) );
+    BOOST_CHECK( !hc.is_holiday(date(2013, 1, 1)) );
+
+    // nested composites are merged into a single calendar
+    detail::holidays_bitmap bitmap;
+    std::vector<holidays_const_ptr> dynamic;
+    hc.flatten(bitmap, dynamic, nullptr);
+    BOOST_CHECK_EQUAL( dynamic.size(), 1 );
+    BOOST_CHECK( dynamic[0] == hfc );
+    BOOST_CHECK( bitmap.test(date(2001, 7, 4)) );
+    BOOST_CHECK( bitmap.test(date(2009, 12, 25)) );
+    BOOST_CHECK( !bitmap.test(date(2010, 1, 1)) );
+  }
+  { // batch queries agree with is_holiday
+    holidays_const_ptr hfv( new holidays_from_vector({date(2009, 1, 1), date(2009, 12, 25), date(2010, 3, 7), date(2011, 1, 3)}) );
+    holidays_const_ptr hfc( new holidays_from_callback([](const date& d) { return d.day() == 7; }) );
+    holidays_const_ptr hfcc( new holidays_from_cached_callback([](const date& d) { return d.day() == 13; }) );
+    const std::vector<holidays_const_ptr> calendars { 
+      holidays_const_ptr(new no_holidays()), hfv, hfc, hfcc, 
+      holidays_const_ptr(new holidays_composite({hfv})), 
+      holidays_const_ptr(new holidays_composite({hfv, hfc, hfcc})) 
+    };
+    
+    const date first(2008, 12, 29), last(2011, 1, 5);
+    const size_t n = (last - first).days();
+    for(auto it=calendars.begin(); it!=calendars.end(); ++it) {
+      for(size_t skip=0; skip<n; skip+=97) {
+        std::vector<uint64_t> bits((n + 63) / 64, 0);
+        (*it)->fill_holidays(first + boost::gregorian::days(skip), last, bits.data());
+        long expected = 0;
+        for(size_t i=skip; i<n; ++i) {
+          bool hol = (*it)->is_holiday(first + boost::gregorian::days(i));
+          expected += hol;
+          BOOST_CHECK_EQUAL( ((bits[(i-skip) >> 6] >> ((i-skip) & 63)) & 1) != 0, hol );
+        }
+        BOOST_CHECK_EQUAL( (*it)->count_holidays(first + boost::gregorian::days(skip), last), expected );
+      }
+      BOOST_CHECK_EQUAL( (*it)->count_holidays(last, first), 0 );
+      BOOST_CHECK_THROW( (*it)->count_holidays(date(boost::gregorian::not_a_date_time), last), std::logic_error );
+    }
+  }
 }
 
 BOOST_AUTO_TEST_SUITE_END()
@@ -106,6 +106,32 @@ BOOST_AUTO_TEST_CASE(test_labelers) {
     BOOST_CHECK_EQUAL(microseconds_labeler::str(ldt, ldt+boost::gregorian::years(4)), "20000901T210145.009865+0100");  
   }
 
+  { // nanoseconds
+    const int64_t ns = detail::epoch_nanoseconds(p);
+    BOOST_CHECK_EQUAL(nanoseconds_labeler::str(p, p+boost::gregorian::years(3)), "20000901T220145.009865000");
+    BOOST_CHECK_EQUAL(nanoseconds_labeler::str(ns + 1, ns + 2), "20000901T220145.009865001");
+    BOOST_CHECK_EQUAL(nanoseconds_labeler::str(ldt, ldt+boost::gregorian::years(4)), "20000901T210145.009865000+0100");
+    BOOST_CHECK_EQUAL((scale_with_timezone<simple_calculator<1ULL>, nanoseconds_labeler>(ldt, 1).to_string()), "20000901T210145.009865000+0100");
+  }
+
+  { // writing into buffers
+    char buffer[max_label_size];
+    for(ptime t(date(1999,12,20), time_duration(0,0,0,1)); t<ptime(date(2001,1,10)); t+=time_duration(13,17,3,1001)) {
+      const boost::gregorian::date d(t.date());
+      BOOST_CHECK_EQUAL(std::string(buffer, date_labeler::write(buffer, t, t)), boost::gregorian::to_iso_string(d));
+      BOOST_CHECK_EQUAL(std::string(buffer, microseconds_labeler::write(buffer, t, t)), boost::posix_time::to_iso_string(t));
+      BOOST_CHECK_EQUAL(std::string(buffer, seconds_labeler::write(buffer, t, t)), boost::posix_time::to_iso_string(ptime(d, time_duration(t.time_of_day().hours(), t.time_of_day().minutes(), t.time_of_day().seconds()))));
+      std::ostringstream months, weekdays;
+      months << d.month() << " " << d.year();
+      weekdays << d.day_of_week() << ", " << boost::gregorian::to_simple_string(d);
+      BOOST_CHECK_EQUAL(std::string(buffer, months_labeler::write(buffer, t, t)), months.str());
+      BOOST_CHECK_EQUAL(std::string(buffer, weekdays_labeler::write(buffer, t, t)), weekdays.str());
+    }
+    BOOST_CHECK_EQUAL(std::string(buffer, hours_labeler::write(buffer, ldt, ldt)), "20000901T210000+0100");
+    BOOST_CHECK_EQUAL(std::string(buffer, utc_hours_scale(p).label(buffer)), "20000901T220000");
+    BOOST_CHECK_EQUAL(std::string(buffer, any_timescale(utc_days_scale(p)).label(buffer)), "20000901");
+  }
+
 }
 
 
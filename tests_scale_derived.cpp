@@ -122,7 +122,21 @@ BOOST_AUTO_TEST_CASE(test_scales_scale_derived) {
 
     BOOST_CHECK_EQUAL( (_sc2 + 10).value(), 13 );
     BOOST_CHECK_EQUAL( (_sc2 - 10).value(), -7 );
-    
+
+  }
+  { // long jumps match stepping one period at a time
+    weekdays_scale fwd = sc, bwd = sc;
+    weekend_days_scale wfwd(ldt), wbwd(ldt);
+    for(int i=0; i<100; ++i, ++fwd, --bwd, ++wfwd, --wbwd) {
+      BOOST_CHECK_EQUAL( sc + i, fwd );
+      BOOST_CHECK_EQUAL( sc - i, bwd );
+      BOOST_CHECK_EQUAL( weekend_days_scale(ldt) + i, wfwd );
+      BOOST_CHECK_EQUAL( weekend_days_scale(ldt) - i, wbwd );
+    }
+    BOOST_CHECK_EQUAL( (sc + 5000).local_time(), ldt + boost::gregorian::days(7000) );
+    BOOST_CHECK_EQUAL( weekdays_scale((ldt + boost::gregorian::days(7000)).utc_time(), sc).value(), 5000 );
+    BOOST_CHECK_EQUAL( weekdays_scale((ldt + boost::gregorian::days(7001)).utc_time(), sc).value(), 5000 );
+    BOOST_CHECK_EQUAL( weekdays_scale((ldt + boost::gregorian::days(7003)).utc_time(), sc).value(), 5001 );
   }
   { // comparison
     BOOST_CHECK_EQUAL(sc, sc);
@@ -165,6 +179,51 @@ BOOST_AUTO_TEST_CASE(test_scales_scale_derived) {
   }
 }
 
+BOOST_AUTO_TEST_CASE(test_scales_weekmask) {
+  const ptime p(date(2000,9,1), time_duration(22, 1, 45, 9865));    // Friday
+  const std::map<std::string, std::vector<std::tuple<int64_t, long, std::string, bool> > > zones_struct_simple  {
+    { "TZ_1", { std::tuple<int64_t, long, std::string, bool> {0, 0, "EST", 0},                      // 1970/01/01 00:00:00
+                std::tuple<int64_t, long, std::string, bool> {3600LL*24*1000000, 3600, "DST", 1}    // 1970/01/02 00:00:00
+              } 
+    },
+  };
+  const auto tz = local_time::time_zone_database::from_struct(zones_struct_simple).time_zone_from_region("TZ_1");
+  const local_date_time ldt(p, tz);
+  const unsigned sun_thu = weekmask::sunday | weekmask::monday | weekmask::tuesday | weekmask::wednesday | weekmask::thursday;
+  const weekmask_selector<days_scale> sel(sun_thu);
+  const auto sc = weekmask_scale(p, 1, tz, sel);
+  
+  { // constructors
+    BOOST_CHECK_THROW( weekmask_selector<days_scale>(0), std::logic_error );
+    BOOST_CHECK_THROW( weekmask_selector<days_scale>(0x80), std::logic_error );
+    BOOST_CHECK_EQUAL( weekmask_selector<days_scale>().mask(), static_cast<unsigned>(weekmask::weekdays) );
+    BOOST_CHECK_EQUAL( (weekmask_scale(p, 1, tz) + 7).local_time(), (weekdays_scale(p, 1, tz) + 7).local_time() );
+    BOOST_CHECK_EQUAL( weekmask_scale(sc), sc );
+    BOOST_CHECK_EQUAL( weekmask_scale(p + time_duration(48,0,0), sc), weekmask_scale(p + time_duration(48,0,0), p, 1, tz, sel) );
+    BOOST_CHECK( weekmask_scale(p, 1, tz) != sc );
+  }
+  { // snapping: Friday goes back to Thursday
+    BOOST_CHECK_EQUAL( sc.local_time(), ldt - boost::gregorian::days(1) );
+    BOOST_CHECK_EQUAL( sc.to_string(), "Thu, 2000-Aug-31" );
+  }
+  { // arithmetic
+    BOOST_CHECK_EQUAL( (sc + 1).to_string(), "Sun, 2000-Sep-03" );
+    BOOST_CHECK_EQUAL( (sc - 4).to_string(), "Sun, 2000-Aug-27" );
+    BOOST_CHECK_EQUAL( (sc + 5000).local_time(), ldt - boost::gregorian::days(1) + boost::gregorian::days(7000) );
+    BOOST_CHECK_EQUAL( weekmask_scale((ldt + boost::gregorian::days(6999)).utc_time(), sc).value(), 5000 );
+    weekmask_scale fwd = sc;
+    for(int i=0; i<50; ++i, ++fwd)
+      BOOST_CHECK_EQUAL( sc + i, fwd );
+  }
+  { // mask fixed at compile time
+    typedef scale_derived<days_scale, weekmask_selector<days_scale, weekmask::weekdays | weekmask::saturday>, weekdays_labeler> mon_sat_scale;
+    const mon_sat_scale sc2(p, 1, tz);
+    BOOST_CHECK_EQUAL( (sc2 + 1).to_string(), "Sat, 2000-Sep-02" );
+    BOOST_CHECK_EQUAL( (sc2 + 2).to_string(), "Mon, 2000-Sep-04" );
+    BOOST_CHECK_EQUAL( mon_sat_scale(p + boost::gregorian::days(14), sc2) - sc2, 12 );
+  }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 
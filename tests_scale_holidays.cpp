@@ -85,6 +85,17 @@ BOOST_AUTO_TEST_CASE(test_scales_scale_holidays) {
   { // reference
     BOOST_CHECK_EQUAL( business_days(p + time_duration(5,0,0), ldt, 1, hol).reference(), sc );
   }
+  { // index shared by the scales built alike
+    int calls = 0;
+    holidays_const_ptr counted( new holidays_from_callback([&calls](const date& d) { ++calls; return d.day() < 3; }) );
+    const business_days a(p, 1, tz, counted);
+    const int built = calls;
+    const business_days b(p, 1, tz, counted);
+    BOOST_CHECK_EQUAL( calls, built );
+    BOOST_CHECK_EQUAL( b + 40, a + 40 );
+    const business_days c(p, 1, nullptr, counted);         // same start in another zone
+    BOOST_CHECK( calls > built );
+  }
   { // assignment
     business_days sc2(ldt + time_duration(24,0,0), 1, hol);
     BOOST_CHECK_EQUAL( sc2 = sc, sc );
@@ -108,6 +119,16 @@ BOOST_AUTO_TEST_CASE(test_scales_scale_holidays) {
     BOOST_CHECK_EQUAL( (_sc + 10).value(), 13 );
     BOOST_CHECK_EQUAL( (_sc - 10).value(), -7 );
   }
+  { // long jumps match stepping one period at a time
+    business_days fwd = sc, bwd = sc;
+    for(int i=0; i<1000; ++i, ++fwd, --bwd) {
+      BOOST_CHECK_EQUAL( sc + i, fwd );
+      BOOST_CHECK_EQUAL( sc - i, bwd );
+    }
+    BOOST_CHECK_EQUAL( business_days(fwd.utc_time(), sc).value(), 1000 );
+    BOOST_CHECK_EQUAL( business_days(bwd.utc_time(), sc).value(), -1000 );
+    BOOST_CHECK_EQUAL( fwd - bwd, 2000 );
+  }
   { // comparison
     BOOST_CHECK_EQUAL(sc, sc);
     BOOST_CHECK( sc != sc+1);
@@ -0,0 +1,120 @@
+
+#include <boost/test/unit_test.hpp>
+#include <iostream>
+#include "timescales.hpp"
+
+// using namespace timescales;
+
+using boost::posix_time::ptime;
+using boost::gregorian::date;
+using boost::posix_time::time_duration;
+
+using namespace timescales;
+
+
+BOOST_AUTO_TEST_SUITE(tests_scales)
+
+
+BOOST_AUTO_TEST_CASE(test_scales_scale_nanoseconds) {
+  const ptime p(date(2000,1,1));
+  const int64_t ns = detail::epoch_nanoseconds(p);
+  const int64_t second = 1000000000LL;
+  const utc_seconds_ns_scale sc(p);
+
+  { // constructors
+    BOOST_CHECK_NO_THROW( utc_seconds_ns_scale(ns, 1) );
+    BOOST_CHECK_THROW( utc_seconds_ns_scale(ns, -1), std::logic_error );
+    BOOST_CHECK_THROW( utc_seconds_ns_scale(ns, ns, 0), std::logic_error );
+    BOOST_CHECK_THROW( utc_seconds_ns_scale(boost::posix_time::not_a_date_time, 1), std::logic_error );
+    BOOST_CHECK_THROW( utc_seconds_ns_scale(boost::posix_time::not_a_date_time, p, 1), std::logic_error );
+    BOOST_CHECK_THROW( utc_seconds_ns_scale(boost::posix_time::not_a_date_time, sc), std::logic_error );
+
+    BOOST_CHECK_EQUAL( utc_seconds_ns_scale(ns, 1), sc );
+    BOOST_CHECK_EQUAL( utc_seconds_ns_scale(ns + 5 * second + 7, ns, 1), sc + 5 );
+    BOOST_CHECK_EQUAL( utc_seconds_ns_scale(ns - 5 * second - 7, ns, 1), sc - 5 );
+    BOOST_CHECK_EQUAL( utc_seconds_ns_scale(p + time_duration(0,0,5), p), utc_seconds_ns_scale(ns + 5 * second, ns, 1) );
+    BOOST_CHECK_EQUAL( sc.at(ns + 3 * second), sc + 3 );
+    BOOST_CHECK_EQUAL( utc_seconds_ns_scale(p + time_duration(0,0,3), sc), sc + 3 );
+    BOOST_CHECK_EQUAL( utc_seconds_ns_scale(3, sc), sc + 3 );
+  }
+  { // range of int64_t nanoseconds
+    const ptime late(date(2300,1,1)), early(date(1600,1,1));
+    BOOST_CHECK_THROW( utc_nanoseconds_scale(late, 1), std::out_of_range );
+    BOOST_CHECK_THROW( utc_nanoseconds_scale(early, 1), std::out_of_range );
+    BOOST_CHECK_THROW( utc_seconds_ns_scale(late, p), std::out_of_range );
+    BOOST_CHECK_THROW( utc_seconds_ns_scale(p, early), std::out_of_range );
+    BOOST_CHECK_THROW( utc_seconds_ns_scale(late, sc), std::out_of_range );
+    BOOST_CHECK_THROW( utc_seconds_ns_scale(early, sc), std::out_of_range );
+    BOOST_CHECK_NO_THROW( utc_seconds_ns_scale(ptime(date(2262,1,1)), sc) );
+    BOOST_CHECK_NO_THROW( utc_seconds_ns_scale(ptime(date(1678,1,1)), sc) );
+
+    const int64_t times[] = { 0, detail::epoch_microseconds(late) };
+    int64_t positions[2];
+    BOOST_CHECK_THROW( sc.positions_into(times, positions, 2), std::out_of_range );
+    const int64_t early_times[] = { detail::epoch_microseconds(early) };
+    BOOST_CHECK_THROW( sc.positions_into(early_times, positions, 1), std::out_of_range );
+  }
+  { // reference
+    BOOST_CHECK_EQUAL( (sc + 7).reference(), sc );
+  }
+  { // length
+    BOOST_CHECK_EQUAL( (sc + 20) - sc, 20 );
+    BOOST_CHECK_EQUAL( sc.value_at(ns + 20 * second - 1), 19 );
+    BOOST_CHECK_EQUAL( sc.value_at(ns - second + 1), 0 );    // truncated toward zero, as the constructors
+  }
+  { // current time
+    const utc_nanoseconds_scale nsc(ns + 1234567, ns, 1);
+    BOOST_CHECK_EQUAL( nsc.nanoseconds(), ns + 1234567 );
+    BOOST_CHECK_EQUAL( nsc.end_nanoseconds(), ns + 1234568 );
+    BOOST_CHECK_EQUAL( nsc.utc_time(), p + time_duration(0,0,0,1234) );
+    BOOST_CHECK_EQUAL( utc_nanoseconds_scale(ns - 1, ns, 1).utc_time(), p - time_duration(0,0,0,1) );
+    BOOST_CHECK_EQUAL( (sc + 2).end_nanoseconds(), ns + 3 * second );
+    BOOST_CHECK_EQUAL( sc.local_time().utc_time(), p );
+    BOOST_CHECK_EQUAL( sc.local_time().zone(), time_zone_const_ptr() );
+  }
+  { // bulk grid and bucketing
+    const utc_milliseconds_ns_scale ms(ns, 3);
+    std::vector<int64_t> grid(37);
+    (ms - 5).nanoseconds_into(grid.data(), grid.size());
+    for(size_t i=0; i<grid.size(); ++i)
+      BOOST_CHECK_EQUAL( grid[i], (ms - 5 + i).nanoseconds() );
+    (ms - 5).utc_microseconds_into(grid.data(), grid.size());
+    for(size_t i=0; i<grid.size(); ++i)
+      BOOST_CHECK_EQUAL( grid[i], detail::epoch_microseconds((ms - 5 + i).utc_time()) );
+
+    std::vector<int64_t> times, positions;
+    for(int i=-40; i<40; ++i)
+      times.push_back(ns + i * 1000001 * 7);
+    times.push_back(ns + 3000000);
+    times.push_back(ns - 3000000);
+    times.push_back(ns + 2999999);
+    times.push_back(ns - 2999999);
+    positions.resize(times.size());
+    ms.nanosecond_positions_into(times.data(), positions.data(), times.size());
+    for(size_t i=0; i<times.size(); ++i)
+      BOOST_CHECK_EQUAL( positions[i], ms.at(times[i]).value() );
+
+    for(auto& t : times)
+      t /= 1000;
+    ms.positions_into(times.data(), positions.data(), times.size());
+    for(size_t i=0; i<times.size(); ++i)
+      BOOST_CHECK_EQUAL( positions[i], utc_milliseconds_ns_scale(detail::from_epoch_microseconds(times[i]), ms).value() );
+  }
+  { // string representation
+    std::stringstream out;
+    BOOST_CHECK_NO_THROW(out << sc + 5);
+    BOOST_CHECK_EQUAL(out.str(), "20000101T000005");
+    BOOST_CHECK_EQUAL(utc_nanoseconds_scale(ns + 1234567, ns, 1).to_string(), "20000101T000000.001234567");
+    BOOST_CHECK_EQUAL(utc_nanoseconds_scale(ns - 1, ns, 1).to_string(), "19991231T235959.999999999");
+    BOOST_CHECK_EQUAL(utc_days_ns_scale(ns, 1).to_string(), "20000101");
+
+    label_arena arena;
+    utc_nanoseconds_scale(ns - 1, ns, 1).labels(3, arena);
+    BOOST_CHECK_EQUAL(arena[0], "19991231T235959.999999999");
+    BOOST_CHECK_EQUAL(arena[1], "20000101T000000");
+    BOOST_CHECK_EQUAL(arena[2], "20000101T000000.000000001");
+  }
+}
+
+
+BOOST_AUTO_TEST_SUITE_END()
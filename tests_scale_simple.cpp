@@ -80,6 +80,51 @@ BOOST_AUTO_TEST_CASE(test_scales_scale_simple) {
     BOOST_CHECK_EQUAL(sc.local_time().zone(), time_zone_const_ptr());
     BOOST_CHECK_EQUAL(sc.utc_time(), p);
   }
+  { // bulk grid and bucketing
+    const utc_hours_scale hs(p, 3);
+    std::vector<int64_t> grid(37);
+    (hs - 5).utc_microseconds_into(grid.data(), grid.size());
+    for(size_t i=0; i<grid.size(); ++i)
+      BOOST_CHECK_EQUAL( grid[i], detail::epoch_microseconds((hs - 5 + i).utc_time()) );
+
+    std::vector<ptime> times;
+    for(int i=-40; i<40; ++i)
+      times.push_back(p + time_duration(7 * i, 13, 0, i));
+    times.push_back(p + time_duration(3, 0, 0));
+    times.push_back(p - time_duration(3, 0, 0));
+    times.push_back(p + time_duration(2, 59, 59, 999999));
+    times.push_back(p - time_duration(2, 59, 59, 999999));
+    times.push_back(ptime(date(1500,1,1)));               // beyond the vector kernels' range
+    times.push_back(ptime(date(2500,1,1), time_duration(1,0,0)));
+    std::vector<int64_t> us, positions(times.size());
+    for(auto& t : times)
+      us.push_back(detail::epoch_microseconds(t));
+    hs.positions_into(us.data(), positions.data(), us.size());
+    for(size_t i=0; i<times.size(); ++i)
+      BOOST_CHECK_EQUAL( positions[i], utc_hours_scale(times[i], hs).value() );
+  }
+  { // bucketing kernels against the scalar division
+    uint64_t x = 88172645463325252ULL;
+    auto next = [&x]() { x ^= x << 13; x ^= x >> 7; x ^= x << 17; return x; };   // xorshift64
+    const int64_t periods[] = { 1, 7, 1000, 3600000000LL, 7 * 86400000000LL, detail::grid_vector_bound - 1 };
+    std::vector<int64_t> t(2003), out(t.size());      // the odd size leaves a scalar tail
+    for(int64_t period : periods) {
+      const int64_t origin = static_cast<int64_t>(next() % (1ULL << 41)) - (1LL << 40);
+      for(size_t i=0; i<t.size(); ++i)
+        t[i] = origin + static_cast<int64_t>(next() % (1ULL << 52)) - (1LL << 51);
+      t[17] = origin + 3 * period;
+      t[18] = origin - 3 * period;
+      t[19] = origin + 3 * period - 1;
+      t[20] = origin - 3 * period + 1;
+      t[41] = origin + detail::grid_vector_bound + 5;   // sends its block through the scalar loop
+      detail::bucket_grid(t.data(), origin, period, out.data(), t.size());
+      for(size_t i=0; i<t.size(); ++i)
+        BOOST_CHECK_EQUAL( out[i], (t[i] - origin) / period );
+      detail::fill_grid(origin, period, out.data(), t.size());
+      for(size_t i=0; i<t.size(); ++i)
+        BOOST_CHECK_EQUAL( out[i], origin + static_cast<int64_t>(i) * period );
+    }
+  }
   { // string representation
     std::stringstream out;
     BOOST_CHECK_NO_THROW(out << sc);
@@ -324,6 +324,58 @@ BOOST_AUTO_TEST_CASE(test_months_scale) {
 }
 
 
+BOOST_AUTO_TEST_CASE(test_civil_arithmetic) {
+  const date epoch(1970,1,1);
+  for(date d(1800,1,1); d<date(2200,1,1); d+=boost::gregorian::days(17)) {
+    int64_t y;
+    unsigned m, dd;
+    detail::civil_from_days((d - epoch).days(), y, m, dd);
+    BOOST_CHECK_EQUAL( date(y, m, dd), d );
+    BOOST_CHECK_EQUAL( detail::days_from_civil(y, m, dd), (d - epoch).days() );
+    BOOST_CHECK_EQUAL( detail::last_day_of_month(y, m), d.end_of_month().day() );
+    for(int n=-25; n<=25; n+=7)
+      BOOST_CHECK_EQUAL( detail::add_months(y, m, dd, n), (d + boost::gregorian::months(n) - epoch).days() );
+  }
+  BOOST_CHECK_EQUAL( detail::add_months(2001, 2, 28, 36), (date(2004,2,29) - epoch).days() );
+  BOOST_CHECK_EQUAL( detail::add_months(2004, 1, 30, 1), (date(2004,2,29) - epoch).days() );
+}
+
+
+BOOST_AUTO_TEST_CASE(test_fixed_offset) {
+  const ptime p(date(2000,9,1), time_duration(22, 1, 45, 9865));
+  const std::map<std::string, std::vector<std::tuple<int64_t, long, std::string, bool> > > zones_struct_fixed  {
+    { "TZ_8", { std::tuple<int64_t, long, std::string, bool> {0, -8*3600, "CST", 0} } },             // 1970/01/01 00:00:00
+  };
+  const auto tz = local_time::time_zone_database::from_struct(zones_struct_fixed).time_zone_from_region("TZ_8");
+  detail::fixed_offset fixed;
+  BOOST_CHECK( detail::fixed_offset_of(tz, detail::epoch_microseconds(p), fixed) );
+  BOOST_CHECK_EQUAL( fixed.offset, 8 * 3600000000LL );
+  BOOST_CHECK( detail::fixed_offset_of(time_zone_const_ptr(), 0, fixed) );
+  BOOST_CHECK_EQUAL( fixed.offset, 0 );
+
+  const days_scale days(p, 2, tz);
+  const months_scale months(p, 1, tz);
+  const int64_t start = detail::epoch_microseconds(p);
+  std::vector<int64_t> times;
+  for(int64_t t=start - 100 * 86400000000LL; t<start + 100 * 86400000000LL; t+=7919000000LL)
+    times.push_back(t);
+  std::vector<int64_t> out(times.size());
+
+  days.positions(times.data(), out.data(), times.size());
+  for(size_t i=0; i<times.size(); ++i)
+    BOOST_CHECK_EQUAL( out[i], days_scale(detail::from_epoch_microseconds(times[i]), days).value() );
+  months.positions(times.data(), out.data(), times.size());
+  for(size_t i=0; i<times.size(); ++i)
+    BOOST_CHECK_EQUAL( out[i], months_scale(detail::from_epoch_microseconds(times[i]), months).value() );
+
+  months.utc_microseconds(out.data(), 24);
+  for(size_t i=0; i<24; ++i) {
+    BOOST_CHECK_EQUAL( out[i], detail::epoch_microseconds((months + i).local_time().utc_time()) );
+    BOOST_CHECK_EQUAL( (months + i).utc_time(), (months + i).local_time().utc_time() );
+  }
+  BOOST_CHECK_EQUAL( (days + 3).to_string(), "20000908" );
+}
+
 BOOST_AUTO_TEST_CASE(test_years_scale) {
   const ptime p(date(2000,9,1), time_duration(22, 1, 45, 9865));
   const std::map<std::string, std::vector<std::tuple<int64_t, long, std::string, bool> > > zones_struct_simple  {
@@ -7,6 +7,7 @@
 #include <boost/filesystem.hpp>
 #include <boost/filesystem/fstream.hpp>
 #include <iostream>
+#include <algorithm>
 #include "timescales.hpp"
 
 using namespace timescales;
@@ -35,6 +36,7 @@ typedef boost::mpl::list<
             utc_hours_scale, 
             utc_days_scale, 
             utc_weeks_scale,
+            utc_seconds_ns_scale,
             /* scales with timezones */
             microseconds_scale, 
             milliseconds_scale, 
@@ -169,6 +171,31 @@ template<> std::vector<ptime> Fixture<utc_seconds_scale>::prev_10({ptime(date(20
                                                                         ptime(date(1999,12,31), time_duration(23,59,51)), 
                                                                });
 
+template<> ptime Fixture<utc_seconds_ns_scale>::start_date(date(2000,1,1));
+template<> ptime Fixture<utc_seconds_ns_scale>::anchor_date(date(2000,1,1));
+template<> std::vector<ptime> Fixture<utc_seconds_ns_scale>::next_10({ptime(date(2000,1,1)), 
+                                                                        ptime(date(2000,1,1), time_duration(0,0,1)), 
+                                                                        ptime(date(2000,1,1), time_duration(0,0,2)), 
+                                                                        ptime(date(2000,1,1), time_duration(0,0,3)), 
+                                                                        ptime(date(2000,1,1), time_duration(0,0,4)), 
+                                                                        ptime(date(2000,1,1), time_duration(0,0,5)), 
+                                                                        ptime(date(2000,1,1), time_duration(0,0,6)), 
+                                                                        ptime(date(2000,1,1), time_duration(0,0,7)), 
+                                                                        ptime(date(2000,1,1), time_duration(0,0,8)), 
+                                                                        ptime(date(2000,1,1), time_duration(0,0,9)) 
+                                                               });
+template<> std::vector<ptime> Fixture<utc_seconds_ns_scale>::prev_10({ptime(date(2000,1,1)), 
+                                                                        ptime(date(1999,12,31), time_duration(23,59,59)), 
+                                                                        ptime(date(1999,12,31), time_duration(23,59,58)), 
+                                                                        ptime(date(1999,12,31), time_duration(23,59,57)), 
+                                                                        ptime(date(1999,12,31), time_duration(23,59,56)), 
+                                                                        ptime(date(1999,12,31), time_duration(23,59,55)), 
+                                                                        ptime(date(1999,12,31), time_duration(23,59,54)), 
+                                                                        ptime(date(1999,12,31), time_duration(23,59,53)), 
+                                                                        ptime(date(1999,12,31), time_duration(23,59,52)), 
+                                                                        ptime(date(1999,12,31), time_duration(23,59,51)), 
+                                                               });
+
 template<> ptime Fixture<utc_minutes_scale>::start_date(date(2000,1,1));
 template<> ptime Fixture<utc_minutes_scale>::anchor_date(date(2000,1,1));
 template<> std::vector<ptime> Fixture<utc_minutes_scale>::next_10({ptime(date(2000,1,1)), 
@@ -515,6 +542,16 @@ BOOST_AUTO_TEST_CASE_TEMPLATE(test_timescale_basic, T, test_types) {
   BOOST_CHECK_EQUAL( ts->begin() , timescale::const_iterator(ts->begin()) );
   BOOST_CHECK_EQUAL( ts->begin() , timescale::const_iterator(std::move(ts->begin())) );
 
+  {
+    auto it = ts->iterator(3);
+    auto moved = std::move(it);
+    BOOST_CHECK( !bool(it) );
+    BOOST_CHECK( !bool(timescale::const_iterator(it)) );
+    BOOST_CHECK_EQUAL( moved, ts->iterator(3) );
+    it = moved;
+    BOOST_CHECK_EQUAL( it, moved );
+  }
+
   BOOST_CHECK_EQUAL( ts->rbegin() , timescale::const_reverse_iterator(ts->rbegin()) );
   BOOST_CHECK_EQUAL( ts->rbegin() , timescale::const_reverse_iterator(std::move(ts->rbegin())) );
 
@@ -654,6 +691,47 @@ BOOST_AUTO_TEST_CASE_TEMPLATE(test_timescale_iterator_time_repr, T, test_types)
     std::unique_ptr<timescale> ts(new T(p));
     BOOST_CHECK_EQUAL( ts->utc_time(10), Fixture<T>::next_10 );
   }
+
+  { // bulk times into caller buffers
+    std::unique_ptr<timescale> ts(new T(p));
+    const ptime epoch(date(1970,1,1));
+    std::vector<ptime> times(10);
+    std::vector<int64_t> us(10);
+    ts->utc_time(times.data(), times.size());
+    ts->utc_microseconds(us.data(), us.size());
+    BOOST_CHECK_EQUAL( times, Fixture<T>::next_10 );
+    for(size_t i=0; i<10; ++i)
+      BOOST_CHECK_EQUAL( us[i], (Fixture<T>::next_10[i] - epoch).total_microseconds() );
+
+    const T sc(p);
+    (sc - 9).utc_time_into(times.data(), times.size());
+    (sc - 9).utc_microseconds_into(us.data(), us.size());
+    for(size_t i=0; i<10; ++i) {
+      BOOST_CHECK_EQUAL( times[i], Fixture<T>::prev_10[9 - i] );
+      BOOST_CHECK_EQUAL( us[i], (Fixture<T>::prev_10[9 - i] - epoch).total_microseconds() );
+    }
+  }
+
+  { // positions of times, sorted or not
+    const T sc(p);
+    const ptime epoch(date(1970,1,1));
+    std::vector<int64_t> us;
+    for(size_t i=0; i<10; ++i)
+      for(int64_t d=-1; d<=1; ++d) {
+        us.push_back((Fixture<T>::prev_10[i] - epoch).total_microseconds() + d);
+        us.push_back((Fixture<T>::next_10[i] - epoch).total_microseconds() + d);
+      }
+    std::sort(us.begin(), us.end());
+    for(size_t k=0; k<2; ++k, std::reverse(us.begin(), us.end())) {
+      std::vector<int64_t> positions(us.size()), virtual_positions(us.size());
+      sc.positions_into(us.data(), positions.data(), us.size());
+      std::unique_ptr<timescale> ts(new T(p));
+      ts->positions(us.data(), virtual_positions.data(), us.size());
+      BOOST_CHECK( positions == virtual_positions );
+      for(size_t i=0; i<us.size(); ++i)
+        BOOST_CHECK_EQUAL( positions[i], T(epoch + boost::posix_time::microseconds(us[i]), sc).value() );
+    }
+  }
   
   {
     std::unique_ptr<timescale> ts(new T(p));
@@ -666,6 +744,75 @@ BOOST_AUTO_TEST_CASE_TEMPLATE(test_timescale_iterator_time_repr, T, test_types)
 }
 
 
+BOOST_AUTO_TEST_CASE_TEMPLATE(test_timescale_typed_range, T, test_types) {
+  ptime p = Fixture<T>::start_date;
+  const T ts(p);
+  
+  auto r = ts.range(10);
+  BOOST_CHECK_EQUAL( r.size(), 10 );
+  BOOST_CHECK_EQUAL( r.end() - r.begin(), 10 );
+  BOOST_CHECK_EQUAL( std::distance(r.begin(), r.end()), 10 );
+  BOOST_CHECK_EQUAL( std::vector<ptime>(r.begin(), r.end()), Fixture<T>::next_10 );
+  BOOST_CHECK( std::is_sorted(r.begin(), r.end()) );
+  BOOST_CHECK( ts.range(0).empty() );
+  BOOST_CHECK( ts.range(0).begin() == ts.range(0).end() );
+  
+  size_t i = 0;
+  for(auto it=r.begin(); it!=r.end(); ++it, ++i) {
+    BOOST_CHECK_EQUAL( *it, Fixture<T>::next_10[i] );
+    BOOST_CHECK_EQUAL( r[i], Fixture<T>::next_10[i] );
+    BOOST_CHECK_EQUAL( it.local_time().utc_time(), Fixture<T>::next_10[i] );
+  }
+
+  auto it = r.begin() + 7;
+  BOOST_CHECK( r.begin() < it && it < r.end() && it >= r.begin() + 7 && it <= r.begin() + 7 && r.end() > it );
+  BOOST_CHECK( 3 + (it - 3) == it );
+  BOOST_CHECK_EQUAL( it[-7], Fixture<T>::next_10[0] );
+  BOOST_CHECK_EQUAL( *--it, Fixture<T>::next_10[6] );
+  BOOST_CHECK_EQUAL( *it--, Fixture<T>::next_10[6] );
+  BOOST_CHECK_EQUAL( *it++, Fixture<T>::next_10[5] );
+  BOOST_CHECK( it.scale() == ts + 6 );
+}
+
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(test_timescale_move, T, test_types) {
+  BOOST_CHECK( std::is_nothrow_move_constructible<T>::value );
+  BOOST_CHECK( std::is_nothrow_move_assignable<T>::value );
+
+  const T ts(Fixture<T>::start_date);
+  T ts2(ts), ts3(ts + 3);
+  T ts4(std::move(ts2));
+  BOOST_CHECK( ts4 == ts );
+  ts4 = std::move(ts3);
+  BOOST_CHECK( ts4 == ts + 3 );
+  BOOST_CHECK( ts4 + 2 == ts + 5 );
+}
+
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(test_timescale_labels, T, test_types) {
+  const T ts(Fixture<T>::start_date);
+
+  label_arena arena;
+  ts.labels(40, arena);
+  BOOST_CHECK_EQUAL( arena.size(), 40 );
+  BOOST_CHECK_EQUAL( arena.offsets().size(), 41 );
+  BOOST_CHECK_EQUAL( arena.offsets()[0], 0 );
+  BOOST_CHECK( std::is_sorted(arena.offsets().begin(), arena.offsets().end()) );
+  for(size_t i=0; i<40; ++i)
+    BOOST_CHECK_EQUAL( arena[i], (ts + i).to_string() );
+
+  std::unique_ptr<timescale> base(new T(ts + 40));
+  base->labels(5, arena);
+  BOOST_CHECK_EQUAL( arena.size(), 45 );
+  BOOST_CHECK_EQUAL( arena[44], (ts + 44).to_string() );
+
+  arena.clear();
+  BOOST_CHECK_EQUAL( arena.size(), 0 );
+  ts.labels(0, arena);
+  BOOST_CHECK_EQUAL( arena.size(), 0 );
+}
+
+
 BOOST_AUTO_TEST_SUITE_END()
 
 
@@ -0,0 +1,96 @@
+#include <boost/test/unit_test.hpp>
+#include <iostream>
+#include "timescales.hpp"
+
+// using namespace timescales;
+
+using boost::posix_time::ptime;
+using boost::gregorian::date;
+using boost::posix_time::time_duration;
+
+using namespace timescales;
+
+
+BOOST_AUTO_TEST_SUITE(tests_scales)
+
+
+BOOST_AUTO_TEST_CASE(test_zone_table) {
+  const int64_t hour = 3600000000LL;
+  const int64_t spring = detail::epoch_microseconds(ptime(date(2000,3,10), time_duration(7,0,0)));
+  const int64_t fall = detail::epoch_microseconds(ptime(date(2000,11,3), time_duration(6,0,0)));
+  const std::map<std::string, std::vector<std::tuple<int64_t, long, std::string, bool> > > zones_struct_dst  {
+    { "TZ_1", { std::tuple<int64_t, long, std::string, bool> {0, 5*3600, "EST", 0},
+                std::tuple<int64_t, long, std::string, bool> {spring, 4*3600, "EDT", 1},
+                std::tuple<int64_t, long, std::string, bool> {fall, 5*3600, "EST", 0}
+              } 
+    },
+  };
+  const auto tz = local_time::time_zone_database::from_struct(zones_struct_dst).time_zone_from_region("TZ_1");
+
+  { // transitions
+    const zone_table table(tz, 1990, 2010);
+    BOOST_CHECK_EQUAL( table.transitions().size(), 2 );
+    BOOST_CHECK_EQUAL( table.transitions()[0], spring );
+    BOOST_CHECK_EQUAL( table.transitions()[1], fall );
+    BOOST_CHECK_EQUAL( table.offsets().size(), 3 );
+    BOOST_CHECK_EQUAL( table.offsets()[1], -4 * hour );
+
+    BOOST_CHECK_THROW( zone_table(tz, 2010, 1990), std::logic_error );
+    BOOST_CHECK_THROW( zone_table(time_zone_const_ptr(), 1990, 2010), std::logic_error );
+  }
+
+  { // conversions
+    const zone_table table(tz, 1990, 2010);
+    int64_t local, utc;
+    BOOST_CHECK( table.local_from_utc(spring - 1, local) );
+    BOOST_CHECK_EQUAL( local, spring - 1 - 5 * hour );
+    BOOST_CHECK( table.local_from_utc(spring, local) );
+    BOOST_CHECK_EQUAL( local, spring - 4 * hour );
+    BOOST_CHECK( table.utc_from_local(spring + 10 * hour, utc) );
+    BOOST_CHECK_EQUAL( utc, spring + 14 * hour );
+    BOOST_CHECK( !table.utc_from_local(spring - 4 * hour, utc) );            // skipped by the transition
+    BOOST_CHECK( !table.utc_from_local(fall - 5 * hour, utc) );              // repeated by the transition
+    BOOST_CHECK( !table.local_from_utc(detail::epoch_microseconds(ptime(date(2011,1,1))), local) );
+  }
+
+  { // shared tables and span
+    BOOST_CHECK( zone_table::get(tz) == zone_table::get(tz) );
+    zone_table::set_years(2001, 2010);
+    BOOST_CHECK_EQUAL( zone_table::get(tz)->transitions().size(), 0 );
+    zone_table::set_years(1970, 2050);
+    BOOST_CHECK_EQUAL( zone_table::get(tz)->transitions().size(), 2 );
+  }
+
+  { // lazy tables
+    zone_table::set_years(1970, 2050);
+    const int64_t year = 366 * 24 * hour;
+    const zone_table& near = zone_table::cached(tz, spring);     // valid until the next lookup
+    const int64_t first = near.first();
+    BOOST_CHECK( first <= spring && spring < near.last() );
+    BOOST_CHECK( near.last() - first <= 3 * year );
+    BOOST_CHECK_EQUAL( near.transitions().size(), 2 );
+
+    const int64_t later = detail::epoch_microseconds(ptime(date(2020,6,1)));
+    const zone_table& far = zone_table::cached(tz, later);
+    BOOST_CHECK( far.first() == first && later < far.last() );
+    BOOST_CHECK_EQUAL( far.transitions().size(), 2 );
+    BOOST_CHECK_EQUAL( far.transitions()[1], fall );
+
+    const int64_t beyond = detail::epoch_microseconds(ptime(date(2100,1,1)));
+    int64_t local;
+    BOOST_CHECK( !zone_table::cached(tz, beyond).local_from_utc(beyond, local) );
+    BOOST_CHECK_EQUAL( zone_table::cached(tz, beyond).last(), detail::epoch_microseconds(ptime(date(2051,1,1))) );
+  }
+
+  { // calculators across the transitions
+    const local_date_time start(ptime(date(2000,1,1), time_duration(12,0,0)), tz);
+    for(long i=0; i<400; i+=7) {
+      BOOST_CHECK( days_calculator::local_time(start, i) == start + boost::gregorian::days(i) );
+      BOOST_CHECK_EQUAL( days_calculator::position_from_utc_time(start, (start + boost::gregorian::days(i)).utc_time()), i );
+      BOOST_CHECK_EQUAL( days_calculator::position_from_utc_time(start, (start + boost::gregorian::days(i)).utc_time() - time_duration(0,0,0,1)), i - 1 );
+    }
+  }
+}
+
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -4,7 +4,11 @@
 
 #include "local_date_time/local_date_time.hpp"
 #include <string>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
 #include <type_traits>
+#include <new>
 #include <boost/iterator/iterator_adaptor.hpp>
 
 namespace timescales {
@@ -12,6 +16,152 @@ namespace timescales {
 using local_time::local_date_time;  
 using local_time::time_zone_const_ptr;  
 using boost::posix_time::ptime;
+
+//! size of the buffers the labelers write labels to
+static const size_t max_label_size = 64;
+
+
+//! Labels stored back to back in one buffer, the i-th one from offsets()[i] to offsets()[i+1].
+class label_arena {
+public:
+  label_arena() : _offsets(1, 0) { }
+
+  //! number of labels
+  size_t size() const { return _offsets.size() - 1; }
+
+  //! removes all the labels, keeping the memory
+  void clear() {
+    _chars.clear();
+    _offsets.assign(1, 0);
+  }
+
+  //! makes room for \a n more labels of \a length chars on average
+  void reserve(size_t n, size_t length=16) {
+    _chars.reserve(_chars.size() + n * length + max_label_size);
+    _offsets.reserve(_offsets.size() + n);
+  }
+
+  //! characters of all the labels
+  const char* data() const { return _chars.data(); }
+
+  //! start of each label in data(), followed by the end of the last one
+  const std::vector<size_t>& offsets() const { return _offsets; }
+
+  //! label \a i
+  std::string operator[] (size_t i) const { return std::string(data() + _offsets[i], _offsets[i+1] - _offsets[i]); }
+
+  //! buffer of max_label_size chars for the next label
+  char* prepare() {
+    _chars.resize(_offsets.back() + max_label_size);
+    return &_chars[_offsets.back()];
+  }
+
+  //! appends the \a length first chars written to prepare()
+  void commit(size_t length) {
+    _offsets.push_back(_offsets.back() + length);
+    _chars.resize(_offsets.back());
+  }
+
+private:
+  std::vector<char>    _chars;
+  std::vector<size_t>  _offsets;
+};
+
+
+namespace detail {
+
+//! number of bits set in \a x
+inline int popcount(uint64_t x) {
+#if defined(__GNUC__)
+  return __builtin_popcountll(x);
+#else
+  x = x - ((x >> 1) & 0x5555555555555555ULL);
+  x = (x & 0x3333333333333333ULL) + ((x >> 2) & 0x3333333333333333ULL);
+  x = (x + (x >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+  return static_cast<int>((x * 0x0101010101010101ULL) >> 56);
+#endif
+}
+
+//! index of the lowest bit set in \a x (\a x must not be 0)
+inline int lowest_bit(uint64_t x) {
+#if defined(__GNUC__)
+  return __builtin_ctzll(x);
+#else
+  return popcount((x & (~x + 1)) - 1);
+#endif
+}
+
+//! microseconds elapsed from 1970-01-01 00:00:00 to \a p
+inline int64_t epoch_microseconds(const ptime& p) {
+  static const ptime epoch(boost::gregorian::date(1970, 1, 1));
+  return (p - epoch).total_microseconds();
+}
+
+//! time \a us microseconds after 1970-01-01 00:00:00
+inline ptime from_epoch_microseconds(int64_t us) {
+  static const ptime epoch(boost::gregorian::date(1970, 1, 1));
+  return epoch + boost::posix_time::microseconds(us);
+}
+
+//! nanoseconds in \a us microseconds, throws std::out_of_range when they do not fit in an int64_t
+inline int64_t nanoseconds_from_microseconds(int64_t us) {
+  if(us > std::numeric_limits<int64_t>::max() / 1000 || us < std::numeric_limits<int64_t>::min() / 1000)
+    throw std::out_of_range("the time is outside of the years 1678 to 2261 covered by int64_t nanoseconds");
+  return us * 1000;
+}
+
+//! nanoseconds elapsed from 1970-01-01 00:00:00 to \a p, throws std::out_of_range when they do not fit in an int64_t
+inline int64_t epoch_nanoseconds(const ptime& p) {
+  return nanoseconds_from_microseconds(epoch_microseconds(p));
+}
+
+//! time \a ns nanoseconds after 1970-01-01 00:00:00, rounded down to the microsecond
+inline ptime from_epoch_nanoseconds(int64_t ns) {
+  return from_epoch_microseconds((ns >= 0 ? ns : ns - 999) / 1000);
+}
+
+//! days from 1970-01-01 to the civil date \a y-\a m-\a d
+inline int64_t days_from_civil(int64_t y, unsigned m, unsigned d) {
+  y -= m <= 2;
+  const int64_t era = (y >= 0 ? y : y - 399) / 400;
+  const unsigned yoe = static_cast<unsigned>(y - era * 400);                  // [0, 399]
+  const unsigned doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;        // [0, 365]
+  const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;                 // [0, 146096]
+  return era * 146097 + static_cast<int64_t>(doe) - 719468;
+}
+
+//! civil date \a y-\a m-\a d, \a z days after 1970-01-01
+inline void civil_from_days(int64_t z, int64_t& y, unsigned& m, unsigned& d) {
+  z += 719468;
+  const int64_t era = (z >= 0 ? z : z - 146096) / 146097;
+  const unsigned doe = static_cast<unsigned>(z - era * 146097);               // [0, 146096]
+  const unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365; // [0, 399]
+  const unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);               // [0, 365]
+  const unsigned mp = (5 * doy + 2) / 153;                                    // [0, 11]
+  d = doy - (153 * mp + 2) / 5 + 1;
+  m = mp < 10 ? mp + 3 : mp - 9;
+  y = static_cast<int64_t>(yoe) + era * 400 + (m <= 2);
+}
+
+//! number of days in the month \a m of the year \a y
+inline unsigned last_day_of_month(int64_t y, unsigned m) {
+  static const unsigned char days[] = { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+  return m == 2 && y % 4 == 0 && (y % 100 != 0 || y % 400 == 0) ? 29 : days[m - 1];
+}
+
+//! days from 1970-01-01 to \a n months after \a y-\a m-\a d
+/*! As with boost::gregorian::months, the last day of a month moves to the last day of the target month,
+ *  and days beyond the end of the target month are brought back to its last day.
+ */
+inline int64_t add_months(int64_t y, unsigned m, unsigned d, int64_t n) {
+  const int64_t t = y * 12 + (m - 1) + n;
+  const int64_t ty = (t >= 0 ? t : t - 11) / 12;
+  const unsigned tm = static_cast<unsigned>(t - ty * 12) + 1;
+  const unsigned last = last_day_of_month(ty, tm);
+  return days_from_civil(ty, tm, d == last_day_of_month(y, m) || d > last ? last : d);
+}
+
+}
   
   
 class timescale {
@@ -61,6 +211,18 @@ public:
   virtual std::vector<local_date_time> local_time(size_t n) const = 0; 
   virtual std::vector<ptime> utc_time(size_t n) const = 0;
 
+  //! writes the utc times of the \a n values starting at the current one to \a out
+  virtual void utc_time(ptime* out, size_t n) const = 0;
+
+  //! writes the utc times of the \a n values starting at the current one to \a out, in microseconds since 1970-01-01
+  virtual void utc_microseconds(int64_t* out, size_t n) const = 0;
+
+  //! writes the values of the scale at the \a n utc times \a utc_us, in microseconds since 1970-01-01, to \a out
+  virtual void positions(const int64_t* utc_us, int64_t* out, size_t n) const = 0;
+
+  //! appends the labels of the \a n values starting at the current one to \a arena
+  virtual void labels(size_t n, label_arena& arena) const = 0;
+
   virtual void shift_to(ssize_t n) = 0;
   virtual void shift_to(const local_date_time&) = 0;
   virtual void shift_to(const ptime&) = 0;
@@ -78,6 +240,12 @@ private:
   //! 
   virtual ssize_t difference(const timescale*) const = 0;
 
+  //! copy constructed in \a buffer if it fits in \a size bytes, on the heap otherwise
+  virtual timescale* copy_into(void* buffer, size_t size) const = 0;
+
+  //! move constructed in \a buffer if it fits in \a size bytes, on the heap otherwise
+  virtual timescale* move_into(void* buffer, size_t size) = 0;
+
 protected:
   //! default constructor
   timescale() { };
@@ -116,17 +284,32 @@ protected:
 
 class timescale::const_iterator : public std::iterator<std::random_access_iterator_tag, ptime, ssize_t, ptime*, ptime> {
 public:
-  const_iterator(const const_iterator& src) : _scale(std::move(src._scale->copy())) { }
+  //! bytes available to hold the scale without allocating, enough for all the scales in timescales_typedefs.hpp
+  static const size_t inline_size = 160;
+  
+  const_iterator(const const_iterator& src) : _scale(src._scale ? src._scale->copy_into(&_buffer, inline_size) : nullptr) { }
     
-  const_iterator(const_iterator&& src) : _scale(std::move(src._scale)) { }
+  const_iterator(const_iterator&& src) : _scale(nullptr) { 
+    steal(src);
+  }
 
+  ~const_iterator() {
+    release();
+  }
+  
   const_iterator& operator = (const const_iterator& src) { 
-    _scale.reset(src._scale->copy().release());
+    if(this != &src) {
+      release();
+      _scale = src._scale ? src._scale->copy_into(&_buffer, inline_size) : nullptr;
+    }
     return *this;
   }
   
   const_iterator& operator = (const_iterator&& src) { 
-    _scale = std::move(src._scale);
+    if(this != &src) {
+      release();
+      steal(src);
+    }
     return *this;
   }
     
@@ -148,7 +331,7 @@ public:
   }
    
   const_iterator operator++(int) {
-    const_iterator it(_scale->copy());
+    const_iterator it(*this);
     ++*this;
     return it;
   }
@@ -159,19 +342,19 @@ public:
   }
    
   const_iterator operator--(int) {
-    const_iterator it(_scale->copy());
+    const_iterator it(*this);
     --*this;
     return it;
   }
 
   const_iterator operator+(size_t n) const {
-    const_iterator newscale(_scale->copy());
+    const_iterator newscale(*this);
     *newscale._scale += n;
     return newscale;
   }
 
   const_iterator operator-(size_t n) const {
-    const_iterator newscale(_scale->copy());
+    const_iterator newscale(*this);
     *newscale._scale -= n;
     return newscale;
   }
@@ -187,7 +370,7 @@ public:
   }
   
   ssize_t operator - (const const_iterator& rhs) const {
-    return _scale->difference(rhs._scale.get());
+    return _scale->difference(rhs._scale);
   }
    
   bool operator != (const const_iterator& rhs) const {
@@ -195,24 +378,42 @@ public:
   }
 
   bool operator == (const const_iterator& rhs) const {
-    return (!_scale && !rhs._scale) || (_scale && rhs._scale && _scale->equals(rhs._scale.get()));
+    return (!_scale && !rhs._scale) || (_scale && rhs._scale && _scale->equals(rhs._scale));
   }
 
   explicit operator bool () const {
-    return bool(_scale);
+    return _scale != nullptr;
   }
   
 private:
-  std::unique_ptr<timescale> _scale;
+  std::aligned_storage<inline_size>::type  _buffer;
+  timescale*                               _scale;      // points to _buffer unless the scale did not fit
 
   friend class timescale;
   
-  explicit const_iterator(std::unique_ptr<timescale>&& scale) : _scale(std::move(scale)) { 
-    // LCOV_EXCL_START
-    if(!_scale)
-      throw std::runtime_error("Invalid iterator.");
-    // LCOV_EXCL_STOP
-  }  
+  explicit const_iterator(const timescale& scale) : _scale(scale.copy_into(&_buffer, inline_size)) { }
+
+  bool is_inline() const {
+    return static_cast<const void*>(_scale) == static_cast<const void*>(&_buffer);
+  }
+  
+  void release() {
+    if(is_inline())
+      _scale->~timescale();
+    else
+      delete _scale;
+    _scale = nullptr;
+  }
+  
+  //! takes the scale of \a src, leaving it empty
+  void steal(const_iterator& src) {
+    if(src.is_inline()) {
+      _scale = src._scale->move_into(&_buffer, inline_size);
+      src.release();
+    }
+    else
+      std::swap(_scale, src._scale);
+  }
 };
 
 
@@ -310,7 +511,7 @@ public:
 private:
   friend class timescale;
 
-  explicit const_reverse_iterator(std::unique_ptr<timescale>&& scale) : _regular_iterator(std::move(scale)) { }  
+  explicit const_reverse_iterator(const_iterator&& it) : _regular_iterator(std::move(it)) { }  
   
   const_iterator _regular_iterator;
 };
@@ -318,32 +519,36 @@ private:
 
 inline timescale::const_iterator timescale::iterator(ssize_t n) const { 
   if (n >= 0)
-    return const_iterator(copy()) + static_cast<size_t>(n);
+    return begin() + static_cast<size_t>(n);
   else
-    return const_iterator(copy()) - static_cast<size_t>(-n);
+    return begin() - static_cast<size_t>(-n);
 }
 
 inline timescale::const_iterator timescale::iterator(const local_date_time& ldt) const { 
-  return const_iterator(copy(ldt));
+  const_iterator it(*this);
+  it._scale->shift_to(ldt);
+  return it;
 }
 
 inline timescale::const_iterator timescale::iterator(const ptime& p) const { 
-  return const_iterator(copy(p));
+  const_iterator it(*this);
+  it._scale->shift_to(p);
+  return it;
 }
 
 inline timescale::const_reverse_iterator timescale::reverse_iterator(ssize_t n) const { 
   if (n >= 0)
-    return const_reverse_iterator(copy()) + static_cast<size_t>(n);
+    return rbegin() + static_cast<size_t>(n);
   else
-    return const_reverse_iterator(copy()) - static_cast<size_t>(-n);
+    return rbegin() - static_cast<size_t>(-n);
 }
 
 inline timescale::const_reverse_iterator timescale::reverse_iterator(const local_date_time& ldt) const { 
-  return const_reverse_iterator(copy(ldt));
+  return const_reverse_iterator(iterator(ldt));
 }
 
 inline timescale::const_reverse_iterator timescale::reverse_iterator(const ptime& p) const { 
-  return const_reverse_iterator(copy(p));
+  return const_reverse_iterator(iterator(p));
 }
 
 
@@ -352,7 +557,7 @@ inline timescale::const_reverse_iterator timescale::reverse_iterator(const ptime
 
 
 inline timescale::const_iterator timescale::begin() const { 
-  return const_iterator(copy());
+  return const_iterator(*this);
 }
 
 inline timescale::const_iterator timescale::end(size_t n) const { 
@@ -360,7 +565,7 @@ inline timescale::const_iterator timescale::end(size_t n) const {
 }
 
 inline timescale::const_reverse_iterator timescale::rbegin() const { 
-  return const_reverse_iterator(copy());
+  return const_reverse_iterator(begin());
 }
 
 inline timescale::const_reverse_iterator timescale::rend(size_t n) const { 
@@ -373,6 +578,122 @@ inline timescale::const_reverse_iterator timescale::rend(size_t n) const {
 
 namespace detail {  
 
+//! Random access iterator over the values of a concrete scale.
+/*! Unlike timescale::const_iterator, the scale is known at compile time and held by value, so 
+ *  stepping and reading the time of the current value are plain inlinable calls.
+ */
+template<class Scale>
+class scale_iterator : public std::iterator<std::random_access_iterator_tag, ptime, ssize_t, const ptime*, ptime> {
+public:
+  explicit scale_iterator(const Scale& scale) : _scale(scale) { }
+  
+  ptime operator*() const { 
+    return _scale.Scale::utc_time();
+  }
+
+  ptime operator[](ssize_t n) const { 
+    return *(*this + n);
+  }
+
+  ptime utc_time() const {
+    return _scale.Scale::utc_time();
+  }
+
+  local_date_time local_time() const {
+    return _scale.Scale::local_time();
+  }
+
+  //! current value of the scale
+  const Scale& scale() const {
+    return _scale;
+  }
+  
+  scale_iterator& operator++() {
+    ++_scale;
+    return *this;
+  }
+   
+  scale_iterator operator++(int) {
+    scale_iterator it(*this);
+    ++_scale;
+    return it;
+  }
+   
+  scale_iterator& operator--() {
+    --_scale;
+    return *this;
+  }
+   
+  scale_iterator operator--(int) {
+    scale_iterator it(*this);
+    --_scale;
+    return it;
+  }
+
+  scale_iterator& operator+=(ssize_t n) {
+    if(n >= 0)
+      _scale += static_cast<size_t>(n);
+    else
+      _scale -= static_cast<size_t>(-n);
+    return *this;
+  }
+
+  scale_iterator& operator-=(ssize_t n) {
+    return *this += -n;
+  }
+  
+  scale_iterator operator+(ssize_t n) const {
+    scale_iterator it(*this);
+    return it += n;
+  }
+
+  friend scale_iterator operator+(ssize_t n, const scale_iterator& it) {
+    return it + n;
+  }
+
+  scale_iterator operator-(ssize_t n) const {
+    scale_iterator it(*this);
+    return it -= n;
+  }
+
+  ssize_t operator-(const scale_iterator& rhs) const {
+    return _scale - rhs._scale;
+  }
+
+  bool operator==(const scale_iterator& rhs) const { return _scale == rhs._scale; }
+  bool operator!=(const scale_iterator& rhs) const { return !(_scale == rhs._scale); }
+  bool operator< (const scale_iterator& rhs) const { return *this - rhs < 0; }
+  bool operator> (const scale_iterator& rhs) const { return *this - rhs > 0; }
+  bool operator<=(const scale_iterator& rhs) const { return *this - rhs <= 0; }
+  bool operator>=(const scale_iterator& rhs) const { return *this - rhs >= 0; }
+
+private:
+  Scale _scale;
+};
+
+
+//! The \a n consecutive values of a concrete scale starting at a given value.
+template<class Scale>
+class scale_range {
+public:
+  typedef scale_iterator<Scale>   iterator;
+  typedef scale_iterator<Scale>   const_iterator;
+  
+  scale_range(const Scale& first, size_t n) : _begin(first), _end(_begin + static_cast<ssize_t>(n)), _size(n) { }
+
+  const_iterator begin() const { return _begin; }
+  const_iterator end() const { return _end; }
+  size_t size() const { return _size; }
+  bool empty() const { return _size == 0; }
+  ptime operator[](size_t i) const { return _begin[static_cast<ssize_t>(i)]; }
+  
+private:
+  const_iterator  _begin;
+  const_iterator  _end;
+  size_t          _size;
+};
+
+
 //! Intermediate timescale class represents a time interval
 /*! 
  */
@@ -420,6 +741,22 @@ private:
     return ptr;
   }
 
+  timescale_base* copy_into(void* buffer, size_t size) const override final {
+    if(fits(buffer, size))
+      return new (buffer) derived(*static_cast<const derived*>(this));
+    return new derived(*static_cast<const derived*>(this));
+  }
+
+  timescale_base* move_into(void* buffer, size_t size) override final {
+    if(fits(buffer, size))
+      return new (buffer) derived(std::move(*static_cast<derived*>(this)));
+    return new derived(std::move(*static_cast<derived*>(this)));
+  }
+
+  static bool fits(const void* buffer, size_t size) {
+    return sizeof(derived) <= size && reinterpret_cast<uintptr_t>(buffer) % std::alignment_of<derived>::value == 0;
+  }
+
   void shift_to(ssize_t n) override final {
     *static_cast<derived*>(this) = derived(n, *static_cast<const derived*>(this));
    }
@@ -467,18 +804,94 @@ public:
   virtual ptime utc_time()  const = 0;
   
   std::vector<ptime> utc_time(size_t n) const override final {
-    return std::vector<ptime>(begin(), end(n));
+    std::vector<ptime> result(n);
+    static_cast<const derived*>(this)->utc_time_into(result.data(), n);
+    return result;
+  }
+
+  void utc_time(ptime* out, size_t n) const override final {
+    static_cast<const derived*>(this)->utc_time_into(out, n);
+  }
+
+  void utc_microseconds(int64_t* out, size_t n) const override final {
+    static_cast<const derived*>(this)->utc_microseconds_into(out, n);
+  }
+
+  void positions(const int64_t* utc_us, int64_t* out, size_t n) const override final {
+    static_cast<const derived*>(this)->positions_into(utc_us, out, n);
+  }
+  
+  //! writes the utc times of the \a n values starting at the current one to \a out
+  /*! Walks the values one at a time, scales with a faster way hide it with their own version.
+   */
+  void utc_time_into(ptime* out, size_t n) const {
+    scale_iterator<derived> it(*static_cast<const derived*>(this));
+    for(size_t i=0; i<n; ++i, ++it)
+      out[i] = *it;
+  }
+
+  //! writes the utc times of the \a n values starting at the current one to \a out, in microseconds since 1970-01-01
+  /*! Walks the values one at a time, scales with a faster way hide it with their own version.
+   */
+  void utc_microseconds_into(int64_t* out, size_t n) const {
+    scale_iterator<derived> it(*static_cast<const derived*>(this));
+    for(size_t i=0; i<n; ++i, ++it)
+      out[i] = epoch_microseconds(*it);
+  }
+
+  //! writes the values of the scale at the \a n utc times \a utc_us, in microseconds since 1970-01-01, to \a out
+  /*! Values grow with the time, so the value found for a time also holds up to the start of the next period
+   *  whenever the time just before that start has the same value. The span is kept while the times stay in
+   *  it: sorted times build two scales per period instead of one per time. Scales with a faster way hide it
+   *  with their own version.
+   */
+  void positions_into(const int64_t* utc_us, int64_t* out, size_t n) const {
+    const derived& self = *static_cast<const derived*>(this);
+    int64_t lo = 0, hi = 0;
+    long v = 0;
+    for(size_t i=0; i<n; ++i) {
+      const int64_t t = utc_us[i];
+      if(t < lo || t >= hi) {
+        const derived sc(from_epoch_microseconds(t), self);
+        v = sc.value();
+        lo = t;
+        hi = epoch_microseconds((sc + 1).derived::utc_time());
+        if(hi <= t || derived(from_epoch_microseconds(hi - 1), self).value() != v)
+          hi = lo;
+      }
+      out[i] = v;
+    }
   }
 
   std::vector<local_date_time> local_time(size_t n) const override final {
     std::vector<local_date_time> result;
     result.reserve(n);
-    const_iterator it = begin();
-    for(size_t i=0; i<n; ++i) {
+    scale_iterator<derived> it(*static_cast<const derived*>(this));
+    for(size_t i=0; i<n; ++i, ++it)
       result.push_back( it.local_time() );
+    return result;
+  }
+  
+  //! appends the labels of the \a n values starting at the current one to \a arena
+  /*! The time labelling each value is computed once, and serves as the end of the previous value. Date
+   *  labelers carry the year, month and day from a label to the next through their cursor.
+   */
+  void labels(size_t n, label_arena& arena) const override final {
+    scale_iterator<derived> it(*static_cast<const derived*>(this));
+    typename derived::labeler_type::cursor_type cursor;
+    auto t0 = it.scale().label_time();
+    arena.reserve(n);
+    for(size_t i=0; i<n; ++i) {
       ++it;
+      auto t1 = it.scale().label_time();
+      arena.commit(derived::write_label(cursor, arena.prepare(), t0, t1));
+      t0 = t1;
     }
-    return result;
+  }
+
+  //! the \a n values starting at this one, iterated without virtual calls
+  scale_range<derived> range(size_t n) const {
+    return scale_range<derived>(*static_cast<const derived*>(this), n);
   }
   
 };
@@ -4,10 +4,40 @@
 
 #include "scale_labeler.hpp"
 #include "scale_simple.hpp"
+#include "scale_nanoseconds.hpp"
+#include "zone_table.hpp"
 #include "scale_with_timezone.hpp"
 #include "scale_derived.hpp"
 #include "scale_with_holidays.hpp"
 #include "timescales_typedefs.hpp"
+#include "any_timescale.hpp"
+#include "bucketer.hpp"
+
+
+namespace timescales {
+namespace detail {
+
+//! true if all the \a Scales are held by timescale::const_iterator without allocating
+template<class... Scales> struct fits_inline;
+
+template<> struct fits_inline<> : std::true_type { };
+
+template<class Scale, class... Scales> struct fits_inline<Scale, Scales...> 
+  : std::integral_constant<bool, (sizeof(Scale) <= timescales::timescale::const_iterator::inline_size) && fits_inline<Scales...>::value> { };
+
+}
+
+static_assert(detail::fits_inline<utc_microseconds_scale, utc_milliseconds_scale, utc_seconds_scale, utc_minutes_scale, 
+                                  utc_hours_scale, utc_days_scale, utc_weeks_scale, 
+                                  utc_nanoseconds_scale, utc_microseconds_ns_scale, utc_milliseconds_ns_scale, utc_seconds_ns_scale, 
+                                  utc_minutes_ns_scale, utc_hours_ns_scale, utc_days_ns_scale, utc_weeks_ns_scale, 
+                                  microseconds_scale, milliseconds_scale, seconds_scale, minutes_scale, hours_scale, 
+                                  days_scale, weeks_scale, months_scale, years_scale, 
+                                  weekdays_scale, utc_weekdays_scale, weekend_days_scale, utc_weekend_days_scale, 
+                                  weekmask_scale, utc_weekmask_scale, 
+                                  days_with_holidays_scale, business_days>::value, 
+              "timescale::const_iterator::inline_size is too small for the predefined scales");
+}
 
 #endif // TIMESCALES_TIMESCALE_FWD_HPP
 
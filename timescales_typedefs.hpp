@@ -5,6 +5,7 @@
 namespace timescales {
   
 template<long, class> class scale_simple;
+template<long, class> class scale_nanoseconds;
 template<class, class> class scale_with_timezone;
 template<class, class, class> class scale_derived;
 template<class, class> class scale_with_holidays;
@@ -23,8 +24,10 @@ struct minutes_labeler;
 struct seconds_labeler;
 struct milliseconds_labeler;
 struct microseconds_labeler;
+struct nanoseconds_labeler;
 template<class> struct weekdays_selector;
 template<class> struct weekend_days_selector;
+template<class, int> struct weekmask_selector;
 
 
 /* independent timescales */
@@ -44,6 +47,25 @@ typedef scale_simple<86400000000ULL, date_labeler>          utc_days_scale;
 typedef scale_simple<604800000000LL, weeks_labeler>         utc_weeks_scale;
 
 
+/* independent timescales on int64 nanoseconds */
+//! Nanoseconds time-scale in UTC
+typedef scale_nanoseconds<1LL, nanoseconds_labeler>                   utc_nanoseconds_scale;
+//! Microseconds time-scale in UTC, on nanoseconds
+typedef scale_nanoseconds<1000LL, microseconds_labeler>               utc_microseconds_ns_scale;
+//! Milliseconds time-scale in UTC, on nanoseconds
+typedef scale_nanoseconds<1000000LL, milliseconds_labeler>            utc_milliseconds_ns_scale;
+//! Seconds time-scale in UTC, on nanoseconds
+typedef scale_nanoseconds<1000000000LL, seconds_labeler>              utc_seconds_ns_scale;
+//! Minutes time-scale in UTC, on nanoseconds
+typedef scale_nanoseconds<60000000000LL, minutes_labeler>             utc_minutes_ns_scale;
+//! Hours time-scale in UTC, on nanoseconds
+typedef scale_nanoseconds<3600000000000LL, hours_labeler>             utc_hours_ns_scale;
+//! Days time-scale in UTC, on nanoseconds
+typedef scale_nanoseconds<86400000000000LL, date_labeler>             utc_days_ns_scale;
+//! Weeks time-scale in UTC, on nanoseconds
+typedef scale_nanoseconds<604800000000000LL, weeks_labeler>           utc_weeks_ns_scale;
+
+
 /* scales with timezones */
 //! Microseconds time-scale with timezone information
 typedef scale_with_timezone<simple_calculator<1ULL>, microseconds_labeler>      microseconds_scale;
@@ -74,6 +96,10 @@ typedef scale_derived<utc_days_scale, weekdays_selector<utc_days_scale>, weekday
 typedef scale_derived<days_scale, weekend_days_selector<days_scale>, weekdays_labeler>          weekend_days_scale;
 //! Weekend days time-scale
 typedef scale_derived<utc_days_scale, weekend_days_selector<utc_days_scale>, weekdays_labeler>  utc_weekend_days_scale;
+//! Time-scale of the days of the week selected by a mask given at runtime, with timezone information
+typedef scale_derived<days_scale, weekmask_selector<days_scale, -1>, weekdays_labeler>          weekmask_scale;
+//! Time-scale of the days of the week selected by a mask given at runtime
+typedef scale_derived<utc_days_scale, weekmask_selector<utc_days_scale, -1>, weekdays_labeler>  utc_weekmask_scale;
 
 
 /* scales with timezones and holidays */
@@ -0,0 +1,372 @@
+#ifndef TIMESCALES_ZONE_TABLE_HPP
+#define TIMESCALES_ZONE_TABLE_HPP
+
+#include "timescale.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace timescales {
+
+//! Utc offsets of a time zone over a span of years, as sorted integer transitions.
+/*! The table only relies on the local_date_time interface: the offset is sampled every sample_step, and each
+ *  change is bisected down to the microsecond. Two transitions closer than sample_step are not seen. Times
+ *  outside of the span, and local times close enough to a transition to be skipped or repeated, are left
+ *  to local_date_time.
+ *
+ *  The tables shared through cached() are built lazily: the first lookup in a zone samples the three years
+ *  around the time looked up, and a time outside of the span doubles it on that side, sampling only the new
+ *  years. The span never leaves the years given to set_years().
+ */
+class zone_table {
+public:
+
+  //! distance between two offset samples, in microseconds
+  static const int64_t sample_step = 6 * 3600000000LL;
+
+  //! Constructor
+  /*! \param tz          time zone
+   *  \param first_year  first year of the table
+   *  \param last_year   last year of the table
+   */
+  zone_table(const time_zone_const_ptr& tz, int first_year, int last_year)
+    : _first_year(first_year), _last_year(last_year), _first(detail::days_from_civil(first_year, 1, 1) * day),
+      _last(detail::days_from_civil(last_year + 1, 1, 1) * day), _max_jump(0), _grows_before(false), _grows_after(false) {
+    if(!tz)
+      throw std::logic_error("a zone table needs a time zone");
+    if(last_year < first_year)
+      throw std::logic_error("the last year of a zone table cannot be before its first year");
+    _offsets.push_back(offset_at(tz, _first));
+    scan(tz, _first, _last);
+    index();
+  }
+
+  //! Constructor
+  /*! \param inner       table of \a tz over years within [first_year, last_year], whose transitions are reused
+   *  \param tz          time zone
+   *  \param first_year  first year of the table
+   *  \param last_year   last year of the table
+   */
+  zone_table(const zone_table& inner, const time_zone_const_ptr& tz, int first_year, int last_year)
+    : _first_year(first_year), _last_year(last_year), _first(detail::days_from_civil(first_year, 1, 1) * day),
+      _last(detail::days_from_civil(last_year + 1, 1, 1) * day), _max_jump(0), _grows_before(false), _grows_after(false) {
+    if(!tz)
+      throw std::logic_error("a zone table needs a time zone");
+    if(first_year > inner._first_year || last_year < inner._last_year)
+      throw std::logic_error("a zone table must hold the years of the table it extends");
+    _offsets.push_back(offset_at(tz, _first));
+    scan(tz, _first, inner._first);
+    _transitions.insert(_transitions.end(), inner._transitions.begin(), inner._transitions.end());
+    _offsets.insert(_offsets.end(), inner._offsets.begin() + 1, inner._offsets.end());
+    scan(tz, inner._last, _last);
+    index();
+  }
+
+
+  //            //
+  // conversion //
+  //            //
+
+  //! sets \a local to the local time of the utc time \a utc, in microseconds since 1970-01-01; false outside of the table
+  bool local_from_utc(int64_t utc, int64_t& local) const {
+    if(utc < _first || utc >= _last)
+      return false;
+    local = utc + _offsets[index_at(utc)];
+    return true;
+  }
+
+  //! sets \a utc to the utc time of the local time \a local, in microseconds since 1970-01-01
+  /*! False outside of the table, and when the local time is close enough to a transition to be skipped or
+   *  repeated by it.
+   */
+  bool utc_from_local(int64_t local, int64_t& utc) const {
+    if(local < _first || local >= _last)
+      return false;
+    const int64_t guess = local - _offsets[index_at(local)];
+    if(guess < _first || guess >= _last)
+      return false;
+    const size_t i = index_at(guess);
+    const int64_t u = local - _offsets[i];
+    if(u < _first || u >= _last || index_at(u) != i)
+      return false;
+    if((i > 0 && u - _transitions[i-1] <= _max_jump) || (i < _transitions.size() && _transitions[i] - u <= _max_jump))
+      return false;
+    utc = u;
+    return true;
+  }
+
+
+  //          //
+  // contents //
+  //          //
+
+  //! utc times, in microseconds since 1970-01-01, at which the offset changes
+  const std::vector<int64_t>& transitions() const { return _transitions; }
+
+  //! offsets in microseconds, the i-th one holding up to the i-th transition
+  const std::vector<int64_t>& offsets() const { return _offsets; }
+
+  //! true when the offset does not change over the span of the table
+  bool fixed() const { return _transitions.empty(); }
+
+  //! start of the span of the table, in utc microseconds since 1970-01-01
+  int64_t first() const { return _first; }
+
+  //! end of the span of the table, excluded, in utc microseconds since 1970-01-01
+  int64_t last() const { return _last; }
+
+
+  //       //
+  // cache //
+  //       //
+
+  //! table of \a tz over the years given to set_years(), built on first use and shared by the threads
+  static std::shared_ptr<const zone_table> get(const time_zone_const_ptr& tz) {
+    registry& r = the_registry();
+    int first_year, last_year;
+    {
+      std::lock_guard<std::mutex> lock(r.mutex);
+      first_year = r.first_year;
+      last_year = r.last_year;
+    }
+    return lookup(tz, first_year, last_year).second;
+  }
+
+  //! table of \a tz spanning the utc time \a utc, unless it is outside of the years given to set_years()
+  /*! The table stays alive until the thread looks up another zone, or a time the table does not span.
+   */
+  static const zone_table& cached(const time_zone_const_ptr& tz, int64_t utc) {
+    // plain thread locals for the hit, the owning pointers are only touched on a miss
+    static thread_local const void*       last_zone = nullptr;
+    static thread_local const zone_table* last_table = nullptr;
+    static thread_local unsigned          last_generation = 0;
+    registry& r = the_registry();
+    const unsigned generation = r.generation.load(std::memory_order_acquire);
+    if(last_table && last_zone == tz.get() && last_generation == generation && last_table->serves(utc))
+      return *last_table;
+
+    static thread_local std::pair<time_zone_const_ptr, std::shared_ptr<const zone_table> > last;
+    const int year = year_of(utc);
+    last = lookup(tz, year, year);
+    last_zone = tz.get();
+    last_table = last.second.get();
+    last_generation = generation;
+    return *last_table;
+  }
+
+  //! bounds the span of the tables to [first_year, last_year], 1970 to 2050 by default
+  /*! Meant to be called once, before the first scale with a time zone: the tables already built are dropped
+   *  and rebuilt on their next use, by every thread.
+   */
+  static void set_years(int first_year, int last_year) {
+    if(last_year < first_year)
+      throw std::logic_error("the last year of a zone table cannot be before its first year");
+    registry& r = the_registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    r.first_year = first_year;
+    r.last_year = last_year;
+    r.tables.clear();
+    r.generation.fetch_add(1, std::memory_order_release);
+  }
+
+private:
+  static const int64_t day = 86400000000LL;
+  static const int64_t bucket = 32 * day;
+
+  int                   _first_year;
+  int                   _last_year;
+  int64_t               _first;
+  int64_t               _last;
+  int64_t               _max_jump;
+  bool                  _grows_before;  // whether the registry extends the table to the earlier times
+  bool                  _grows_after;   // whether the registry extends the table to the later times
+  std::vector<int64_t>  _transitions;
+  std::vector<int64_t>  _offsets;
+  std::vector<size_t>   _buckets;       // transitions before the start of each bucket
+
+  struct registry {
+    registry() : generation(1), first_year(1970), last_year(2050) { }
+
+    std::mutex                                                                                   mutex;
+    std::atomic<unsigned>                                                                        generation;
+    int                                                                                          first_year;
+    int                                                                                          last_year;
+    std::map<const void*, std::pair<std::weak_ptr<const void>, std::shared_ptr<const zone_table> > > tables;
+  };
+
+  static registry& the_registry() {
+    static registry r;
+    return r;
+  }
+
+  //! true when the registry has no better table than this one for \a utc
+  bool serves(int64_t utc) const {
+    return (utc >= _first || !_grows_before) && (utc < _last || !_grows_after);
+  }
+
+  //! year of the utc time \a utc, in microseconds since 1970-01-01
+  static int year_of(int64_t utc) {
+    int64_t y;
+    unsigned m, d;
+    detail::civil_from_days((utc >= 0 ? utc : utc - day + 1) / day, y, m, d);
+    return y < std::numeric_limits<int>::min() ? std::numeric_limits<int>::min() :
+           y > std::numeric_limits<int>::max() ? std::numeric_limits<int>::max() : static_cast<int>(y);
+  }
+
+  //! zone and table of \a tz in the registry, built or extended to the years [first_year, last_year] when missing
+  /*! The years are brought within those of set_years(). The sampling runs without the lock, two threads
+   *  missing the same zone may both build a table, the larger one is kept.
+   */
+  static std::pair<time_zone_const_ptr, std::shared_ptr<const zone_table> > lookup(const time_zone_const_ptr& tz, int first_year, int last_year) {
+    registry& r = the_registry();
+    std::shared_ptr<const zone_table> current;
+    unsigned generation;
+    int lo, hi, min_year, max_year;
+    {
+      std::lock_guard<std::mutex> lock(r.mutex);
+      for(auto it=r.tables.begin(); it!=r.tables.end(); )  // zones gone, their address may come back
+        it = it->second.first.expired() ? r.tables.erase(it) : ++it;
+      min_year = r.first_year;
+      max_year = r.last_year;
+      first_year = std::min(std::max(first_year, min_year), max_year);
+      last_year = std::min(std::max(last_year, min_year), max_year);
+      auto it = r.tables.find(tz.get());
+      if(it != r.tables.end()) {
+        current = it->second.second;
+        if(current->_first_year <= first_year && current->_last_year >= last_year)
+          return std::make_pair(tz, current);
+      }
+      generation = r.generation.load(std::memory_order_relaxed);
+    }
+
+    // three years around the first time looked up, then double the span on the side that needs it
+    if(current) {
+      const int span = current->_last_year - current->_first_year + 1;
+      lo = first_year < current->_first_year ? std::min(first_year, current->_first_year - span) : current->_first_year;
+      hi = last_year > current->_last_year ? std::max(last_year, current->_last_year + span) : current->_last_year;
+    }
+    else {
+      lo = first_year - 1;
+      hi = last_year + 1;
+    }
+    lo = std::max(lo, min_year);
+    hi = std::min(hi, max_year);
+    std::shared_ptr<zone_table> table(current ? new zone_table(*current, tz, lo, hi) : new zone_table(tz, lo, hi));
+    table->_grows_before = lo > min_year;
+    table->_grows_after = hi < max_year;
+
+    std::lock_guard<std::mutex> lock(r.mutex);
+    if(r.generation.load(std::memory_order_relaxed) != generation)
+      return std::make_pair(tz, std::shared_ptr<const zone_table>(table));   // the years changed meanwhile
+    auto& entry = r.tables[tz.get()];
+    if(!entry.second || entry.first.expired() ||
+       (entry.second->_first_year >= lo && entry.second->_last_year <= hi)) {
+      entry.first = tz;
+      entry.second = table;
+    }
+    return std::make_pair(tz, entry.second->_first_year <= first_year && entry.second->_last_year >= last_year ? 
+                                entry.second : std::shared_ptr<const zone_table>(table));
+  }
+
+  //! appends the transitions in (from, to] to the table, whose last offset must be the one at \a from
+  void scan(const time_zone_const_ptr& tz, int64_t from, int64_t to) {
+    int64_t offset = _offsets.back();
+    for(int64_t t=from, next=t+sample_step; t<to; t=next, next+=sample_step) {
+      int64_t next_offset = offset_at(tz, std::min(next, to));
+      if(next_offset == offset)
+        continue;
+      int64_t lo = t, hi = std::min(next, to);  // offset at lo differs from the one at hi
+      while(hi - lo > 1) {
+        const int64_t mid = lo + (hi - lo) / 2;
+        (offset_at(tz, mid) == offset ? lo : hi) = mid;
+      }
+      _transitions.push_back(hi);
+      _offsets.push_back(offset_at(tz, hi));
+      offset = _offsets.back();
+      next = hi;  // look for another change before the next sample
+    }
+  }
+
+  //! sets the largest jump and the buckets of the transitions
+  void index() {
+    for(size_t i=1; i<_offsets.size(); ++i)
+      _max_jump = std::max(_max_jump, std::abs(_offsets[i] - _offsets[i-1]));
+    for(int64_t b=_first; b<_last; b+=bucket)
+      _buckets.push_back(std::lower_bound(_transitions.begin(), _transitions.end(), b) - _transitions.begin());
+  }
+
+  //! offset of \a tz at \a utc
+  static int64_t offset_at(const time_zone_const_ptr& tz, int64_t utc) {
+    const ptime p(detail::from_epoch_microseconds(utc));
+    return detail::epoch_microseconds(local_date_time(p, tz).local_time()) - utc;
+  }
+
+  //! index in offsets() of the offset at \a utc, which must be in the table
+  size_t index_at(int64_t utc) const {
+    size_t i = _buckets[(utc - _first) / bucket];
+    while(i < _transitions.size() && _transitions[i] <= utc)
+      ++i;
+    return i;
+  }
+};
+
+
+namespace detail {
+
+//! sets \a local to the local time in \a tz of \a utc, in microseconds since 1970-01-01; false when a zone table cannot tell
+inline bool local_from_utc(const time_zone_const_ptr& tz, int64_t utc, int64_t& local) {
+  if(!tz) {
+    local = utc;
+    return true;
+  }
+  return zone_table::cached(tz, utc).local_from_utc(utc, local);
+}
+
+//! sets \a utc to the utc time of the local time \a local in \a tz, in microseconds since 1970-01-01; false when a zone table cannot tell
+inline bool utc_from_local(const time_zone_const_ptr& tz, int64_t local, int64_t& utc) {
+  if(!tz) {
+    utc = local;
+    return true;
+  }
+  return zone_table::cached(tz, local).utc_from_local(local, utc);
+}
+
+//! Utc offset of a zone over the utc times [first, last), in microseconds.
+struct fixed_offset {
+  int64_t offset;
+  int64_t first;
+  int64_t last;
+
+  //! true when \a utc is in [first, last)
+  bool covers(int64_t utc) const { return utc >= first && utc < last; }
+};
+
+//! sets \a fixed to the offset of \a tz when it does not change over the span of its zone table around the utc
+//! time \a utc, false otherwise
+inline bool fixed_offset_of(const time_zone_const_ptr& tz, int64_t utc, fixed_offset& fixed) {
+  if(!tz) {
+    fixed.offset = 0;
+    fixed.first = std::numeric_limits<int64_t>::min();
+    fixed.last = std::numeric_limits<int64_t>::max();
+    return true;
+  }
+  const zone_table& table = zone_table::cached(tz, utc);
+  if(!table.fixed())
+    return false;
+  fixed.offset = table.offsets().front();
+  fixed.first = table.first();
+  fixed.last = table.last();
+  return true;
+}
+
+}
+
+
+}
+
+#endif // TIMESCALES_ZONE_TABLE_HPP